@@ -0,0 +1,26 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+
+namespace audio_plugin_benchmark {
+    /** Runs a benchmark for every block size from 16 to 4096 samples at each supported sample rate, read back with blockSize() and sampleRate() */
+    inline void blockSizesAndSampleRates(benchmark::internal::Benchmark *b) {
+        b->ArgNames({"block", "rate"});
+        b->ArgsProduct({{16, 64, 256, 1024, 4096}, {44100, 48000, 96000, 192000}});
+    }
+
+    inline int blockSize(const benchmark::State &state) { return static_cast<int>(state.range(0)); }
+
+    inline float sampleRate(const benchmark::State &state) { return static_cast<float>(state.range(1)); }
+
+    /** Reports the cost per sample and the throughput, call after the benchmark loop
+     * @param samplesPerIteration - number of samples processed in each iteration of the loop
+     */
+    inline void setSampleCounters(benchmark::State &state, int samplesPerIteration) {
+        const auto samples = static_cast<double>(samplesPerIteration);
+
+        state.counters["samples/s"] = benchmark::Counter(samples, benchmark::Counter::kIsIterationInvariantRate);
+        // the inverse of the rate is seconds per sample, shown with an SI prefix (e.g. 12.3ns)
+        state.counters["time/sample"] = benchmark::Counter(samples, benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+    }
+}
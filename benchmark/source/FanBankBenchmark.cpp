@@ -0,0 +1,100 @@
+#include "BenchmarkUtils.h"
+#include <PhysicalModellingFan/components/audio/jr_FanBank.h>
+#include <PhysicalModellingFan/components/audio/jr_SimpleFan.h>
+#include <PhysicalModellingFan/utils/jr_WorkerPool.h>
+#include <vector>
+
+namespace audio_plugin_benchmark {
+    namespace {
+        constexpr float bankSampleRate{48000.0f};
+        constexpr int bankBlockSize{512};
+
+        int numFans(const benchmark::State &state) { return static_cast<int>(state.range(0)); }
+
+        void fanCounts(benchmark::internal::Benchmark *b) {
+            b->ArgNames({"fans"});
+            for (int fans : {1, 4, 16, 64, 256})
+                b->Arg(fans);
+        }
+
+        void prepareBank(jr::FanBank &bank, int fans) {
+            bank.prepare(bankSampleRate, bankBlockSize, fans);
+            bank.setNumVoices(fans);
+            bank.setSeed(1);
+
+            for (int voice = 0; voice < fans; voice++) {
+                jr::FanBank::VoiceParameters params;
+                params.speed = 4.0f + static_cast<float>(voice % 8);
+                params.dopplerOn = voice % 2 == 0;
+                bank.setVoiceParameters(voice, params);
+            }
+        }
+    }
+
+    void fanBank(benchmark::State &state) {
+        jr::FanBank bank;
+        prepareBank(bank, numFans(state));
+
+        std::vector<float> left(bankBlockSize), right(bankBlockSize);
+
+        for (auto _ : state) {
+            bank.processBlock(left.data(), right.data(), bankBlockSize);
+            benchmark::DoNotOptimize(left.data());
+            benchmark::ClobberMemory();
+        }
+
+        setSampleCounters(state, bankBlockSize * numFans(state));
+    }
+
+    // the bank rendered across a pool with a thread for each core, the speed up over fanBank is what the parallel mode is worth
+    void fanBankParallel(benchmark::State &state) {
+        jr::WorkerPool pool(juce::SystemStats::getNumCpus());
+
+        jr::FanBank bank;
+        prepareBank(bank, numFans(state));
+        bank.setWorkerPool(&pool);
+
+        std::vector<float> left(bankBlockSize), right(bankBlockSize);
+
+        for (auto _ : state) {
+            bank.processBlock(left.data(), right.data(), bankBlockSize);
+            benchmark::DoNotOptimize(left.data());
+            benchmark::ClobberMemory();
+        }
+
+        setSampleCounters(state, bankBlockSize * numFans(state));
+    }
+
+    // the same number of fans, one FanPropeller each, as the baseline for the bank
+    void fanPropellers(benchmark::State &state) {
+        std::vector<jr::FanPropeller> fans(static_cast<size_t>(numFans(state)));
+        for (size_t i = 0; i < fans.size(); i++) {
+            fans[i].setSampleRate(bankSampleRate);
+            fans[i].setMaxBlockSize(bankBlockSize);
+            fans[i].setSeed(i);
+            fans[i].setDopplerOn(i % 2 == 0);
+        }
+
+        std::vector<float> speed(bankBlockSize, 8.0f), left(bankBlockSize), right(bankBlockSize), mixLeft(bankBlockSize), mixRight(bankBlockSize);
+
+        for (auto _ : state) {
+            juce::FloatVectorOperations::clear(mixLeft.data(), bankBlockSize);
+            juce::FloatVectorOperations::clear(mixRight.data(), bankBlockSize);
+
+            for (auto &fan : fans) {
+                fan.processBlock(speed.data(), left.data(), right.data(), bankBlockSize);
+                juce::FloatVectorOperations::add(mixLeft.data(), left.data(), bankBlockSize);
+                juce::FloatVectorOperations::add(mixRight.data(), right.data(), bankBlockSize);
+            }
+
+            benchmark::DoNotOptimize(mixLeft.data());
+            benchmark::ClobberMemory();
+        }
+
+        setSampleCounters(state, bankBlockSize * numFans(state));
+    }
+
+    BENCHMARK(fanBank)->Apply(fanCounts);
+    BENCHMARK(fanBankParallel)->Apply(fanCounts);
+    BENCHMARK(fanPropellers)->Apply(fanCounts);
+}
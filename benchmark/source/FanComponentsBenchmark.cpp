@@ -0,0 +1,92 @@
+#include "BenchmarkUtils.h"
+#include <PhysicalModellingFan/components/audio/jr_SimpleFan.h>
+#include <cmath>
+#include <vector>
+
+namespace audio_plugin_benchmark {
+    namespace {
+        // raw sine of the fan tone at 8 Hz, used as the control signal of the noise, doppler and delay components
+        std::vector<float> makeControlSignal(int numSamples, float sampleRate) {
+            std::vector<float> signal(static_cast<size_t>(numSamples));
+            for (size_t i = 0; i < signal.size(); i++)
+                signal[i] = std::sin(juce::MathConstants<float>::twoPi * 8.0f * static_cast<float>(i) / sampleRate);
+
+            return signal;
+        }
+    }
+
+    void fanToneComponent(benchmark::State &state) {
+        jr::FanToneComponent tone;
+        tone.setSampleRate(sampleRate(state));
+
+        const auto numSamples = static_cast<size_t>(blockSize(state));
+        std::vector<float> speed(numSamples, 8.0f), rawSine(numSamples), rawSignal(numSamples), out(numSamples);
+
+        for (auto _ : state) {
+            tone.processBlock(speed.data(), rawSine.data(), rawSignal.data(), out.data(), blockSize(state));
+            benchmark::DoNotOptimize(out.data());
+            benchmark::ClobberMemory();
+        }
+
+        setSampleCounters(state, blockSize(state));
+    }
+
+    template <size_t filterType>
+    void fanNoiseComponent(benchmark::State &state) {
+        jr::FanNoiseComponent noise;
+        noise.setSampleRate(sampleRate(state));
+        noise.setFilterType(filterType);
+        noise.setSeed(1);
+
+        const auto rawSignal = makeControlSignal(blockSize(state), sampleRate(state));
+        std::vector<float> out(rawSignal.size());
+
+        for (auto _ : state) {
+            noise.processBlock(rawSignal.data(), out.data(), blockSize(state));
+            benchmark::DoNotOptimize(out.data());
+            benchmark::ClobberMemory();
+        }
+
+        setSampleCounters(state, blockSize(state));
+    }
+
+    void fanDopplerComponent(benchmark::State &state) {
+        jr::FanDopplerComponent doppler;
+        doppler.setSampleRate(sampleRate(state));
+        doppler.setDopplerOn(true);
+        doppler.setSeed(1);
+
+        const auto control = makeControlSignal(blockSize(state), sampleRate(state));
+        std::vector<float> out(control.size());
+
+        for (auto _ : state) {
+            doppler.processBlock(control.data(), control.data(), out.data(), blockSize(state));
+            benchmark::DoNotOptimize(out.data());
+            benchmark::ClobberMemory();
+        }
+
+        setSampleCounters(state, blockSize(state));
+    }
+
+    void fanDelay(benchmark::State &state) {
+        jr::FanDelay delay;
+        delay.setSampleRate(sampleRate(state));
+
+        const auto control = makeControlSignal(blockSize(state), sampleRate(state));
+        std::vector<float> out(control.size());
+
+        for (auto _ : state) {
+            delay.processBlock(control.data(), control.data(), out.data(), blockSize(state));
+            benchmark::DoNotOptimize(out.data());
+            benchmark::ClobberMemory();
+        }
+
+        setSampleCounters(state, blockSize(state));
+    }
+
+    BENCHMARK(fanToneComponent)->Apply(blockSizesAndSampleRates);
+    BENCHMARK_TEMPLATE(fanNoiseComponent, jr::FanNoiseComponent::bandPassType)->Apply(blockSizesAndSampleRates);
+    BENCHMARK_TEMPLATE(fanNoiseComponent, jr::FanNoiseComponent::lowPassType)->Apply(blockSizesAndSampleRates);
+    BENCHMARK(fanDopplerComponent)->Apply(blockSizesAndSampleRates);
+    BENCHMARK(fanDelay)->Apply(blockSizesAndSampleRates);
+}
@@ -0,0 +1,33 @@
+#include "BenchmarkUtils.h"
+#include <PhysicalModellingFan/components/audio/jr_Delay.h>
+#include <cmath>
+#include <vector>
+
+namespace audio_plugin_benchmark {
+    template <bool withFeedback>
+    void fractionalDelay(benchmark::State &state) {
+        jr::FractionalDelay delay;
+        delay.setSampleRate(sampleRate(state));
+        delay.setSize(0.4f);
+        delay.setWetMix(0.5f);
+        delay.setFeedback(withFeedback ? 0.3f : 0.0f);
+
+        // a delay time that moves every sample, between 190 and 210 ms like the fan delay
+        const auto numSamples = static_cast<size_t>(blockSize(state));
+        std::vector<float> in(numSamples, 0.5f), delayTimes(numSamples), out(numSamples);
+        for (size_t i = 0; i < numSamples; i++)
+            delayTimes[i] = (0.2f + 0.01f * std::sin(static_cast<float>(i) * 0.01f)) * sampleRate(state);
+
+        for (auto _ : state) {
+            delay.process(in.data(), delayTimes.data(), out.data(), blockSize(state));
+            benchmark::DoNotOptimize(out.data());
+            benchmark::ClobberMemory();
+        }
+
+        setSampleCounters(state, blockSize(state));
+    }
+
+    // without feedback the block path is used, with feedback every sample depends on the last
+    BENCHMARK_TEMPLATE(fractionalDelay, false)->Apply(blockSizesAndSampleRates);
+    BENCHMARK_TEMPLATE(fractionalDelay, true)->Apply(blockSizesAndSampleRates);
+}
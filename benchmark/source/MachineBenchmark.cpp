@@ -0,0 +1,73 @@
+#include "BenchmarkUtils.h"
+#include <PhysicalModellingFan/components/audio/jr_Machine.h>
+#include <vector>
+
+namespace audio_plugin_benchmark {
+    void machineEnvelope(benchmark::State &state) {
+        jr::MachineEnvelope envelope;
+        envelope.setSampleRate(sampleRate(state));
+
+        std::vector<float> out(static_cast<size_t>(blockSize(state)));
+        bool isOn = false;
+
+        for (auto _ : state) {
+            // switching every block keeps the envelope moving, so both the power up and the power down curves are measured
+            isOn = !isOn;
+            isOn ? envelope.powerOn() : envelope.powerOff();
+
+            envelope.processBlock(out.data(), blockSize(state));
+            benchmark::DoNotOptimize(out.data());
+            benchmark::ClobberMemory();
+        }
+
+        setSampleCounters(state, blockSize(state));
+    }
+
+    void fanPropeller(benchmark::State &state) {
+        jr::FanPropeller fan;
+        fan.setSampleRate(sampleRate(state));
+        fan.setMaxBlockSize(blockSize(state));
+        fan.setDopplerOn(true);
+        fan.setSeed(1);
+
+        const auto numSamples = static_cast<size_t>(blockSize(state));
+        std::vector<float> speed(numSamples, 8.0f), left(numSamples), right(numSamples);
+
+        for (auto _ : state) {
+            fan.processBlock(speed.data(), left.data(), right.data(), blockSize(state));
+            benchmark::DoNotOptimize(left.data());
+            benchmark::DoNotOptimize(right.data());
+            benchmark::ClobberMemory();
+        }
+
+        setSampleCounters(state, blockSize(state));
+    }
+
+    void machine(benchmark::State &state) {
+        jr::Machine machine;
+        machine.prepare(sampleRate(state), blockSize(state));
+        machine.setSeed(1);
+
+        // running at full speed, so the idle path is never taken
+        jr::MachineParameters params;
+        params.speed = 8.0f;
+        params.dopplerOn = true;
+        params.powerOn = true;
+        machine.setParameters(params);
+
+        std::vector<float> left(static_cast<size_t>(blockSize(state))), right(left.size());
+
+        for (auto _ : state) {
+            machine.processBlock(left.data(), right.data(), blockSize(state));
+            benchmark::DoNotOptimize(left.data());
+            benchmark::DoNotOptimize(right.data());
+            benchmark::ClobberMemory();
+        }
+
+        setSampleCounters(state, blockSize(state));
+    }
+
+    BENCHMARK(machineEnvelope)->Apply(blockSizesAndSampleRates);
+    BENCHMARK(fanPropeller)->Apply(blockSizesAndSampleRates);
+    BENCHMARK(machine)->Apply(blockSizesAndSampleRates);
+}
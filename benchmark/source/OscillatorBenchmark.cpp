@@ -0,0 +1,32 @@
+#include "BenchmarkUtils.h"
+#include <PhysicalModellingFan/components/audio/jr_PolyBLEP_Oscillators.h>
+#include <vector>
+
+namespace audio_plugin_benchmark {
+    using Mode = jr::Oscillator::OscillatorMode;
+
+    template <Mode mode>
+    void polyblepOscillator(benchmark::State &state) {
+        jr::polyblepOscillator osc;
+        osc.setSampleRate(sampleRate(state));
+        osc.setMode(mode);
+        osc.setMuted(false);
+
+        // the fan drives its oscillators with a frequency for every sample
+        std::vector<float> frequencies(static_cast<size_t>(blockSize(state)), 220.0f);
+        std::vector<float> out(frequencies.size());
+
+        for (auto _ : state) {
+            osc.processNextBlock(out.data(), frequencies.data(), blockSize(state));
+            benchmark::DoNotOptimize(out.data());
+            benchmark::ClobberMemory();
+        }
+
+        setSampleCounters(state, blockSize(state));
+    }
+
+    BENCHMARK_TEMPLATE(polyblepOscillator, Mode::SINE)->Apply(blockSizesAndSampleRates);
+    BENCHMARK_TEMPLATE(polyblepOscillator, Mode::SAW)->Apply(blockSizesAndSampleRates);
+    BENCHMARK_TEMPLATE(polyblepOscillator, Mode::SQUARE)->Apply(blockSizesAndSampleRates);
+    BENCHMARK_TEMPLATE(polyblepOscillator, Mode::TRIANGLE)->Apply(blockSizesAndSampleRates);
+}
@@ -0,0 +1,29 @@
+#include "BenchmarkUtils.h"
+#include <PhysicalModellingFan/PluginProcessor.h>
+
+namespace audio_plugin_benchmark {
+    void audioProcessorProcessBlock(benchmark::State &state) {
+        AudioPluginAudioProcessor processor;
+        processor.setRateAndBufferSizeDetails(sampleRate(state), blockSize(state));
+        processor.prepareToPlay(sampleRate(state), blockSize(state));
+
+        auto &apvts = processor.getAPVTS();
+        apvts.getParameter(ID::SPEED)->setValueNotifyingHost(apvts.getParameter(ID::SPEED)->convertTo0to1(8.0f));
+        apvts.getParameter(ID::FAN_DOPPLER)->setValueNotifyingHost(1.0f);
+        apvts.getParameter(ID::POWER)->setValueNotifyingHost(1.0f);
+
+        juce::AudioBuffer<float> buffer(2, blockSize(state));
+        juce::MidiBuffer midi;
+
+        for (auto _ : state) {
+            processor.processBlock(buffer, midi);
+            benchmark::DoNotOptimize(buffer.getReadPointer(0));
+            benchmark::ClobberMemory();
+        }
+
+        processor.releaseResources();
+        setSampleCounters(state, blockSize(state));
+    }
+
+    BENCHMARK(audioProcessorProcessBlock)->Apply(blockSizesAndSampleRates);
+}
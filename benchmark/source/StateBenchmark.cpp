@@ -0,0 +1,75 @@
+#include "BenchmarkUtils.h"
+#include <PhysicalModellingFan/PluginProcessor.h>
+
+namespace audio_plugin_benchmark {
+    namespace {
+        void setUpState(AudioPluginAudioProcessor &processor) {
+            auto &apvts = processor.getAPVTS();
+            apvts.getParameter(ID::SPEED)->setValueNotifyingHost(apvts.getParameter(ID::SPEED)->convertTo0to1(8.0f));
+            apvts.getParameter(ID::FAN_DOPPLER)->setValueNotifyingHost(1.0f);
+            apvts.getParameter(ID::POWER)->setValueNotifyingHost(1.0f);
+            apvts.state.setProperty(jr::PresetManager::presetNameProperty, "Ceiling Fan", nullptr);
+        }
+
+        // the state as it was written before the binary format, kept here as the baseline
+        void getXmlState(AudioPluginAudioProcessor &processor, juce::MemoryBlock &destData) {
+            const auto xml = processor.getAPVTS().copyState().createXml();
+            juce::AudioProcessor::copyXmlToBinary(*xml, destData);
+        }
+    }
+
+    void stateSaveXml(benchmark::State &state) {
+        AudioPluginAudioProcessor processor;
+        setUpState(processor);
+        juce::MemoryBlock data;
+
+        for (auto _ : state) {
+            getXmlState(processor, data);
+            benchmark::DoNotOptimize(data.getData());
+        }
+
+        state.counters["bytes"] = static_cast<double>(data.getSize());
+    }
+
+    void stateSaveBinary(benchmark::State &state) {
+        AudioPluginAudioProcessor processor;
+        setUpState(processor);
+        juce::MemoryBlock data;
+
+        for (auto _ : state) {
+            processor.getStateInformation(data);
+            benchmark::DoNotOptimize(data.getData());
+        }
+
+        state.counters["bytes"] = static_cast<double>(data.getSize());
+    }
+
+    void stateLoadXml(benchmark::State &state) {
+        AudioPluginAudioProcessor processor;
+        setUpState(processor);
+        juce::MemoryBlock data;
+        getXmlState(processor, data);
+
+        for (auto _ : state)
+            processor.setStateInformation(data.getData(), static_cast<int>(data.getSize()));
+
+        state.counters["bytes"] = static_cast<double>(data.getSize());
+    }
+
+    void stateLoadBinary(benchmark::State &state) {
+        AudioPluginAudioProcessor processor;
+        setUpState(processor);
+        juce::MemoryBlock data;
+        processor.getStateInformation(data);
+
+        for (auto _ : state)
+            processor.setStateInformation(data.getData(), static_cast<int>(data.getSize()));
+
+        state.counters["bytes"] = static_cast<double>(data.getSize());
+    }
+
+    BENCHMARK(stateSaveXml);
+    BENCHMARK(stateSaveBinary);
+    BENCHMARK(stateLoadXml);
+    BENCHMARK(stateLoadBinary);
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+namespace ID
+{
+    const juce::String GAIN = "GAIN";
+    const juce::String SPEED = "SPEED";
+    const juce::String FAN_TONE = "FAN_TONE";
+    const juce::String FAN_NOISE = "FAN_NOISE";
+    const juce::String FAN_WIDTH = "FAN_WIDTH";
+    const juce::String FAN_DOPPLER = "FAN_DOPPLER";
+    const juce::String POWER = "POWER";
+    const juce::String POWER_UP_T = "POWER_UP_T";
+    const juce::String POWER_DOWN_T = "POWER_DOWN_T";
+    const juce::String ACCEL_RATE = "ACCEL_RATE";
+    const juce::String INSTRUMENT_MODE = "INSTRUMENT_MODE";
+}
@@ -2,6 +2,7 @@
 
 #include "PluginProcessor.h"
 #include <PhysicalModellingFan/components/gui/PresetPanel.h>
+#include <PhysicalModellingFan/components/gui/jr_CpuMeter.h>
 #include <PhysicalModellingFan/components/gui/jr_FanControls.h>
 #include <PhysicalModellingFan/components/gui/jr_SharedControls.h>
 #include <PhysicalModellingFan/LookAndFeel/jr_StyleSheet.h>
@@ -25,6 +26,7 @@ private:
     jr::FanControls fanControls;
     jr::SharedControls sharedControls;
     jr::PresetPanel presetPanel;
+    jr::CpuMeter cpuMeter;
 
     jr::CustomLookAndFeel myLookAndFeel;
 
@@ -2,23 +2,13 @@
 
 #include <juce_core/juce_core.h>
 #include <juce_audio_processors/juce_audio_processors.h>
+#include <PhysicalModellingFan/components/audio/jr_FanSynth.h>
 #include <PhysicalModellingFan/components/audio/jr_Machine.h>
-#include <PhysicalModellingFan/components/audio/ApvtsListener.h>
+#include <PhysicalModellingFan/components/audio/jr_MachineEventQueue.h>
+#include <PhysicalModellingFan/components/services/jr_CpuLoadMeter.h>
+#include <PhysicalModellingFan/components/services/jr_PresetLoader.h>
 #include <PhysicalModellingFan/components/services/jr_PresetManager.h>
-
-namespace ID
-{
-    const juce::String GAIN = "GAIN";
-    const juce::String SPEED = "SPEED";
-    const juce::String FAN_TONE = "FAN_TONE";
-    const juce::String FAN_NOISE = "FAN_NOISE";
-    const juce::String FAN_WIDTH = "FAN_WIDTH";
-    const juce::String FAN_DOPPLER = "FAN_DOPPLER";
-    const juce::String POWER = "POWER";
-    const juce::String POWER_UP_T = "POWER_UP_T";
-    const juce::String POWER_DOWN_T = "POWER_DOWN_T";
-    const juce::String ACCEL_RATE = "ACCEL_RATE";
-}
+#include <PhysicalModellingFan/ParameterIDs.h>
 
 //==============================================================================
 class AudioPluginAudioProcessor final : public juce::AudioProcessor
@@ -62,27 +52,41 @@ public:
 
     //==============================================================================
 
-    // shared
-    void togglePower(bool powerOn) { machine.togglePower(powerOn); }
-    void setSpeed(float speed) { machine.setSpeed(speed); }
-
-    // envelope
-    void setPowerUpTime(float seconds) { machine.setPowerUpTime(seconds); }
-    void setPowerDownTime(float seconds) { machine.setPowerDownTime(seconds); }
-
-    // fan
-    void setMasterGain(float gain) { machine.setGain(gain); }
-    void setFanToneLevel(float level) { machine.setFanToneLevel(level); }
-    void setFanNoiseLevel(float level) { machine.setFanNoiseLevel(level); }
-    void setFanStereoWidth(float width) { machine.setFanStereoWidth(width); }
-    void setFanDoppler(bool isOn) { machine.setFanDoppler(isOn); }
-
     juce::AudioProcessorValueTreeState &getAPVTS() { return apvts; }
 
+    /** Schedules a parameter change at a position on the timeline, so it is rendered on the same sample whatever the host block size.
+     * Call from one thread only, in time order. Host automation has no sample offsets in JUCE so it is still applied at the start of each block
+     * @param timeInSamples - timeline position (samples)
+     * @param id - parameter to change
+     * @param value - new value
+     * @return false if the event list is full
+     */
+    bool scheduleParameterChange(juce::int64 timeInSamples, jr::MachineParameterId id, float value) { return eventQueue.push(timeInSamples, id, value); }
+
+    /** Seeds the noise generators, so renders of the same parameters are identical. Call while the processor is not playing
+     * @param seed - seed value
+     */
+    void setSeed(uint64_t seed)
+    {
+        machine.setSeed(seed);
+        synth.setSeed(seed);
+    }
+
+    /** Sets how long the sound of the old preset fades out for when a new preset is loaded. Call before prepareToPlay()
+     * @param timeInS - crossfade time, 0 switches straight to the new preset (seconds)
+     */
+    void setPresetCrossfadeTime(float timeInS) { presetCrossfadeTimeInS = juce::jmax(0.0f, timeInS); }
+
     juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
 
     jr::PresetManager &getPresetManager() { return *presetManager; }
 
+    /** Returns the loader presets are read through, so they reach the audio thread without waiting on the message thread */
+    jr::PresetLoader &getPresetLoader() { return presetLoader; }
+
+    /** Returns the load of processBlock() against the real time deadline, safe to read from any thread */
+    jr::CpuLoadMeter &getCpuLoadMeter() { return cpuLoadMeter; }
+
 private:
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioPluginAudioProcessor)
@@ -91,24 +95,61 @@ private:
 
     jr::Machine machine{};
 
+    static constexpr int numSynthVoices{16}; // voices allocated for instrument mode, the most notes that sound at once
+    jr::FanSynth synth{};                    // plays a fan for each note in instrument mode, in place of the machine
+
     juce::AudioProcessorValueTreeState apvts;
 
-    jr::ApvtsListener masterGainListener{[&](float newValue)
-                                         { setMasterGain(newValue); }};
-    jr::ApvtsListener speedListener{[&](float newValue)
-                                    { setSpeed(newValue); }};
-    jr::ApvtsListener fanToneLevelListener{[&](float newValue)
-                                           { setFanToneLevel(newValue); }};
-    jr::ApvtsListener fanNoiseLevelListener{[&](float newValue)
-                                            { setFanNoiseLevel(newValue); }};
-    jr::ApvtsListener fanStereoWidthListener{[&](float newValue)
-                                             { setFanStereoWidth(newValue); }};
-    jr::ApvtsListener fanDopplerToggleListener{[&](bool newValue)
-                                               { setFanDoppler(newValue); }};
-    jr::ApvtsListener powerToggleListener{[&](bool newValue)
-                                          { togglePower(newValue); }};
-    jr::ApvtsListener powerUpTimeListener{[&](float newValue)
-                                          { setPowerUpTime(newValue); }};
-    jr::ApvtsListener powerDownTimeListener{[&](float newValue)
-                                            { setPowerDownTime(newValue); }};
+    jr::PresetLoader presetLoader{apvts};
+    jr::MachineParameters presetParameters{}; // parameters of a preset that is not in the apvts yet
+
+    jr::Machine fadeMachine{};           // copy of the machine as it was before a preset was loaded, faded out over the new one
+    std::vector<float> fadeLeft;         // output of fadeMachine for part of a block
+    std::vector<float> fadeRight;        // output of fadeMachine for part of a block
+    float presetCrossfadeTimeInS{0.02f}; // seconds
+    int fadeLengthInSamples{};           // length of the crossfade (samples)
+    int fadeSamplesRemaining{};          // samples of the current crossfade still to render
+
+    jr::MachineEventQueue eventQueue;                                                  // parameter changes scheduled on the timeline
+    std::array<jr::MachineParameterEvent, jr::MachineEventQueue::capacity> blockEvents{}; // changes due in the current block
+    juce::int64 timelinePosition{};                                                     // timeline position of the next block, used when the host has no playhead (samples)
+
+    jr::CpuLoadMeter cpuLoadMeter; // load of each block against its deadline, shown in the editor
+
+    /** Reads the current value of every parameter, the values are atomics written by the host so this is safe to call from the audio thread */
+    jr::MachineParameters readParameters() const;
+
+    /** Loads a state written by getStateInformation() in the binary format, see StateCodec
+     * @param data - the state
+     * @param sizeInBytes - size of the state
+     */
+    void setBinaryState(const void *data, size_t sizeInBytes);
+
+    /** Renders the synth, starting and stopping notes on the sample each MIDI message is due
+     * @param left - buffer for the left channel out
+     * @param right - buffer for the right channel out
+     * @param numSamples - number of samples in the block
+     * @param midiMessages - MIDI for the block
+     */
+    void renderInstrument(float *left, float *right, int numSamples, const juce::MidiBuffer &midiMessages);
+
+    /** Fades the old preset out over the start of the new one, using the sound of fadeMachine
+     * @param left - left channel, holding the output of the new preset
+     * @param right - right channel, holding the output of the new preset
+     * @param numSamples - number of samples in the block
+     */
+    void renderPresetCrossfade(float *left, float *right, int numSamples);
+
+    //============ raw parameter values, owned by the apvts ============//
+
+    std::atomic<float> *gainParam{};
+    std::atomic<float> *speedParam{};
+    std::atomic<float> *fanToneParam{};
+    std::atomic<float> *fanNoiseParam{};
+    std::atomic<float> *fanWidthParam{};
+    std::atomic<float> *fanDopplerParam{};
+    std::atomic<float> *powerParam{};
+    std::atomic<float> *powerUpTimeParam{};
+    std::atomic<float> *powerDownTimeParam{};
+    std::atomic<float> *instrumentModeParam{};
 };
@@ -0,0 +1,97 @@
+/*
+  ==============================================================================
+
+    jr_ControlRateRamp.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+namespace jr
+{
+    /**
+    Runs a slowly changing value at control rate. The target is only calculated once every control interval, for the first sample of the interval,
+    and the value starts each interval on the target and carries on along the slope between the last two targets until the next update.
+    Only samples that have already arrived are read, so a ramp carries on unchanged across the end of a block and the output is the same however
+    the samples are split into blocks, even for block sizes that are not a multiple of the interval. A control interval of 1 gives the per sample value.
+    The first target is jumped to straight away as there is nothing to ramp from.
+    */
+    class ControlRateRamp
+    {
+    public:
+        /** Sets how often a new target is calculated
+         * @param numSamples - control interval in samples (at least 1)
+         */
+        void setInterval(int numSamples)
+        {
+            if (numSamples > 0)
+            {
+                interval = numSamples;
+                samplesUntilUpdate = juce::jmin(samplesUntilUpdate, interval);
+            }
+        }
+
+        int getInterval() const { return interval; }
+
+        /** Forgets the current value, so the next target is jumped to without ramping
+         */
+        void reset()
+        {
+            samplesUntilUpdate = 0;
+            hasValue = false;
+        }
+
+        /** Writes a block of ramped values
+         * @param out - buffer for the value of each sample
+         * @param numSamples - number of samples to process
+         * @param getTarget - called with the index of a sample in the block to get the target value at that sample, only called at the start of each ramp
+         */
+        template <typename TargetFunction>
+        void process(float *out, int numSamples, TargetFunction &&getTarget)
+        {
+            int i = 0;
+
+            while (i < numSamples)
+            {
+                if (samplesUntilUpdate <= 0)
+                {
+                    const float target = getTarget(i);
+
+                    if (!hasValue)
+                    {
+                        lastTarget = target;
+                        hasValue = true;
+                    }
+
+                    // the value is exact at each update, and following the slope does not lag a moving target by an interval as ramping towards it would
+                    value = target;
+                    step = (target - lastTarget) / static_cast<float>(interval);
+                    lastTarget = target;
+                    samplesUntilUpdate = interval;
+                }
+
+                const int numInSegment = juce::jmin(samplesUntilUpdate, numSamples - i);
+
+                for (int j = 0; j < numInSegment; j++)
+                {
+                    out[i + j] = value;
+                    value += step;
+                }
+
+                samplesUntilUpdate -= numInSegment;
+                i += numInSegment;
+            }
+        }
+
+    private:
+        int interval{16};         // number of samples between target updates
+        int samplesUntilUpdate{}; // samples remaining until the next target update
+        bool hasValue{};          // false until the first target update
+        float value{};            // current (interpolated) value
+        float step{};             // change of value each sample until the next target update
+        float lastTarget{};       // target calculated at the last update
+    };
+}
@@ -8,49 +8,57 @@
 
 #pragma once
 
+#include <PhysicalModellingFan/utils/jr_StateArchive.h>
 #include <juce_core/juce_core.h>
+#include <vector>
 
 namespace jr
 {
     /**
-    A delay class using a Fractional Delay Line for smoother delay time variation. Use setSampleRate(), setSize() and setDelayTime() before use - the call process() each sample for output
+    A delay class using a Fractional Delay Line for smoother delay time variation. Use setSampleRate(), setSize() and setDelayTime() before use - the call process() each sample for output,
+    or use the block process() with a delay time for each sample.
+    The delay buffer is a ring buffer sized by setSize() for the current sample rate, rounded up to a power of two so positions wrap with a bit mask.
+    It is only reallocated when setSize() needs a different size, and copying onto a delay of the same size copies the buffer in place without allocating.
     */
     class FractionalDelay
     {
     public:
-        /**
-         * Destructor, releases buffer memory on instance destruction
-         *
-         * @return
-         */
-        ~FractionalDelay()
-        {
-            delete[] buffer;
-        }
+        FractionalDelay() {}
 
         /**
-         * sets the sample rate
+         * sets the sample rate, call setSize() afterwards to size the buffer for it. Until then the longest delay is limited to what the buffer holds
          *
          * @param sr - sample rate, Hz
          */
         void setSampleRate(float sr)
         {
             sampleRate = sr;
+
+            updateMaxDelayInSamples();
         }
 
         /**
-         * sets the size of the delay buffer, which is effectively the maximum possible delay time
+         * sets the size of the delay buffer for the current sample rate, which is effectively the maximum possible delay time.
+         * Memory is only allocated when the size changes, so call this when preparing rather than while processing. The buffer is always cleared
          *
          * @param maxDelayTime - maximum delay time/length, seconds
          */
         void setSize(float maxDelayTime)
         {
-            if (maxDelayTime < 0.01)
-                size = static_cast<int>(0.01f * sampleRate);
-            else
-                size = static_cast<int>(maxDelayTime * sampleRate);
-            buffer = new float[size];
+            maxDelayTimeInS = juce::jmax(maxDelayTime, 0.01f);
 
+            // room for the longest delay, plus the sample after it for interpolation
+            const auto requiredSize = static_cast<int>(std::ceil(maxDelayTimeInS * sampleRate)) + 2;
+            const auto newSize = juce::nextPowerOfTwo(requiredSize);
+
+            if (newSize != static_cast<int>(buffer.size()))
+            {
+                // a buffer left over from a higher sample rate is freed rather than kept
+                buffer = std::vector<float>(static_cast<size_t>(newSize), 0.0f);
+                mask = newSize - 1;
+            }
+
+            updateMaxDelayInSamples();
             clearBuffer();
         }
 
@@ -61,25 +69,17 @@ namespace jr
          */
         void setDelayTime(float delayTime)
         {
-            delayTimeInSamples = delayTime * sampleRate;
-
-            readPos = writePos - delayTimeInSamples;
-            while (readPos < 0)
-                readPos += size;
+            setDelayTimeInSamples(delayTime * sampleRate);
         }
 
         /**
          * sets the delay time/delay length directly in samples
          *
-         * @param delayTimeInSamplesIn - delay time, samples
+         * @param delayTimeInSamplesIn - delay time, samples (1 to the size set with setSize())
          */
         void setDelayTimeInSamples(float delayTimeInSamplesIn)
         {
-            delayTimeInSamples = delayTimeInSamplesIn;
-
-            readPos = writePos - delayTimeInSamples;
-            if (readPos < 0)
-                readPos += size;
+            delayTimeInSamples = constrainDelay(delayTimeInSamplesIn);
         }
 
         /**
@@ -89,12 +89,7 @@ namespace jr
          */
         void setFeedback(float feedback)
         {
-            if (feedback > 1)
-                feedbackAmt = 1;
-            if (feedback < 0)
-                feedbackAmt = 0;
-            else
-                feedbackAmt = feedback;
+            feedbackAmt = juce::jlimit(0.0f, 1.0f, feedback);
         }
 
         /**
@@ -103,12 +98,7 @@ namespace jr
          */
         void setWetMix(float mix)
         {
-            if (mix > 1)
-                wetMix = 1;
-            if (mix < 0)
-                wetMix = 0;
-            else
-                wetMix = mix;
+            wetMix = juce::jlimit(0.0f, 1.0f, mix);
         }
 
         /**
@@ -119,7 +109,7 @@ namespace jr
          */
         float process(float drySignal)
         {
-            float output = readVal();
+            float output = readDelayed(writePos, delayTimeInSamples);
 
             writeVal((output * feedbackAmt) + drySignal);
 
@@ -127,22 +117,61 @@ namespace jr
         }
 
         /**
-         * returns the sample value that correlates with current readPos in delay buffer, and increments readPos
+         * processes a block of samples, with a separate delay time for each sample.
+         * When there is no feedback the whole input block is written first and the reads have no dependency on each other
          *
-         * @return readV - sample value for readPos
+         * @param in - dry signal in
+         * @param delayTimes - delay time for each sample, samples (1 to the size set with setSize())
+         * @param out - buffer for the wet/dry mixed signal out, can be the same as in
+         * @param numSamples - number of samples to process
          */
-        float readVal()
+        void process(const float *in, const float *delayTimes, float *out, int numSamples)
         {
-            float readV = linearInterpolation(readPos);
+            jassert(!buffer.empty());
+
+            const float dryMix = 1.0f - wetMix;
+
+            // with feedback, or when the block could wrap round onto the delayed samples, each read has to come before the following write
+            if (feedbackAmt != 0.0f || numSamples + static_cast<int>(maxDelayInSamples) + 1 > mask)
+            {
+                for (int i = 0; i < numSamples; i++)
+                {
+                    delayTimeInSamples = constrainDelay(delayTimes[i]);
+                    out[i] = process(in[i]);
+                }
+                return;
+            }
+
+            const int blockStart = writePos;
 
-            readPos++;
+            // the delay is always at least one sample, so every read below only uses samples written before it
+            for (int i = 0; i < numSamples; i++)
+                writeVal(in[i]);
 
-            if (readPos >= size)
+            for (int i = 0; i < numSamples; i++)
             {
-                readPos -= size;
+                const float delayed = readDelayed(blockStart + i, constrainDelay(delayTimes[i]));
+                out[i] = (delayed * wetMix) + (dryMix * in[i]);
             }
 
-            return readV;
+            delayTimeInSamples = constrainDelay(delayTimes[numSamples - 1]);
+        }
+
+        /**
+         * returns the length of the delay buffer, the longest delay at the current sample rate rounded up to a power of two
+         *
+         * @return bufferSize - samples
+         */
+        int getBufferSize() const { return static_cast<int>(buffer.size()); }
+
+        /**
+         * returns the sample value that is the current delay time behind the writePos
+         *
+         * @return readV - delayed sample value
+         */
+        float readVal() const
+        {
+            return readDelayed(writePos, delayTimeInSamples);
         }
 
         /**
@@ -152,12 +181,9 @@ namespace jr
          */
         void writeVal(float sampleIn)
         {
-            buffer[writePos] = sampleIn;
-
-            writePos++;
+            buffer[static_cast<size_t>(writePos)] = sampleIn;
 
-            if (writePos >= size)
-                writePos = 0;
+            writePos = (writePos + 1) & mask;
         }
 
         /**
@@ -165,44 +191,74 @@ namespace jr
          */
         void clearBuffer()
         {
-            for (int i = 0; i < size; i++)
-            {
-                buffer[i] = 0.0f;
-            }
+            std::fill(buffer.begin(), buffer.end(), 0.0f);
+            writePos = 0;
         }
 
         /**
-         * returns the interpolated sample value for an index value that lies between two discreet index values in an array
+         * saves or restores the delay state. Only the samples that can still be read are copied, so the state is much smaller than the buffer,
+         * and a delay restored from it reads exactly what the saved one would have. The sample rate and size must match the delay the state was saved from
          *
-         * @param readPosIn - index value to be evaluated
-         * @return interpolatedSample - the interpolated sample value that correlates to _readPos
+         * @param archive - archive to save into or restore from
          */
-        float linearInterpolation(float readPosIn)
+        void serialiseState(StateArchive &archive)
         {
-            int indexA = static_cast<int>(readPosIn);
-            int indexB = indexA + 1;
+            archive.expect(sampleRate);
+            archive.expect(mask);
+            archive.expect(maxDelayInSamples);
+            archive(delayTimeInSamples, feedbackAmt, wetMix, writePos);
+
+            writePos &= mask;
+
+            // the longest delay reads the sample after it for interpolation, anything older is overwritten before it is read again
+            const int historySize = buffer.empty() ? 0 : juce::jmin(mask + 1, static_cast<int>(std::ceil(maxDelayInSamples)) + 2);
+            const int historyStart = (writePos - historySize) & mask;
+            const int numBeforeWrap = juce::jmin(historySize, mask + 1 - historyStart);
+
+            archive.array(buffer.data() + historyStart, static_cast<size_t>(numBeforeWrap));
+            archive.array(buffer.data(), static_cast<size_t>(historySize - numBeforeWrap));
+        }
 
-            if (indexB >= size)
-                indexB -= size;
+    private:
+        /**
+         * returns the linearly interpolated sample value a fractional number of samples before a write position
+         *
+         * @param writeIndex - position the next sample will be written to
+         * @param delay - delay in samples, at least 1
+         * @return interpolatedSample - interpolated value between the two nearest samples
+         */
+        float readDelayed(int writeIndex, float delay) const
+        {
+            const int wholeDelay = static_cast<int>(delay);
+            const float fraction = delay - static_cast<float>(wholeDelay);
 
-            jassert(indexA >= 0 && indexA <= size);
-            jassert(indexB >= 0 && indexB <= size);
+            const int indexA = (writeIndex - wholeDelay) & mask;
+            const int indexB = (indexA - 1) & mask;
 
-            float remainder = readPosIn - indexA;
+            return ((1.0f - fraction) * buffer[static_cast<size_t>(indexA)]) + (fraction * buffer[static_cast<size_t>(indexB)]);
+        }
 
-            float interpolatedSample = (remainder * buffer[indexB]) + ((1 - remainder) * buffer[indexA]);
+        /** limits a delay time in samples to the range that can be read from the buffer */
+        float constrainDelay(float delay) const
+        {
+            return juce::jlimit(1.0f, maxDelayInSamples, delay);
+        }
 
-            return interpolatedSample;
+        /** recalculates the longest allowed delay, called when the sample rate or size changes. It is kept within the buffer, which is only resized by setSize() */
+        void updateMaxDelayInSamples()
+        {
+            const float bufferLimit = static_cast<float>(juce::jmax(1, mask - 1));
+            maxDelayInSamples = juce::jlimit(1.0f, bufferLimit, maxDelayTimeInS * sampleRate);
         }
 
-    private:
-        float sampleRate{};         // sample rate, Hz
-        float *buffer;              // delay buffer, array of floats
-        int size{};                 // size of delay buffer in samples (maximum delay length in samples)
-        float delayTimeInSamples{}; // current delay time/length in samples
-        float feedbackAmt{0.0f};    // feedback amount (0 - 1), amount of wet signal fed back through the delay line
-        float readPos{0.0f};        // index of delay buffer array where output is currently being output from
-        int writePos{0};            // index of delay buffer array where delayed signal is currently being written to
-        float wetMix{0.33f};        // dry/wet mix of wet signal vs. dry signal, 0 = only dry, 1 = only wet
+        float sampleRate{44100.0f};     // sample rate, Hz
+        std::vector<float> buffer;      // delay buffer, power of two length
+        int mask{};                     // size of delay buffer - 1, used to wrap positions
+        float maxDelayTimeInS{0.01f};   // maximum delay time set by setSize(), seconds
+        float maxDelayInSamples{1.0f};  // maximum delay time at the current sample rate, samples
+        float delayTimeInSamples{1.0f}; // current delay time/length in samples
+        float feedbackAmt{0.0f};        // feedback amount (0 - 1), amount of wet signal fed back through the delay line
+        int writePos{0};                // index of delay buffer array where delayed signal is currently being written to
+        float wetMix{0.33f};            // dry/wet mix of wet signal vs. dry signal, 0 = only dry, 1 = only wet
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,174 @@
+/*
+  ==============================================================================
+
+    jr_FanBank.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <PhysicalModellingFan/components/audio/jr_NoiseGenerator.h>
+#include <PhysicalModellingFan/utils/jr_WorkerPool.h>
+#include <PhysicalModellingFan/utils/jr_simdUtils.h>
+#include <vector>
+
+namespace jr
+{
+    /**
+    Renders a bank of independent fans mixed down to stereo, for scenes with many more fans than it would be practical to run a Machine for each.
+    Each fan is modelled the same way as FanPropeller: a pulse tone that follows the blade speed, band pass noise (swept by the blades when doppler is on)
+    for the main blades, low pass noise through a delay modulated by the blades for the fast blades, and a pan that follows the blades.
+    The state of every fan is stored as structure-of-arrays, with one SIMD register holding the same value for a group of SimdUtils::width fans,
+    so each instruction processes a whole group. Use prepare() before use, then setNumVoices() and setVoiceParameters(), and call processBlock() each block.
+    The groups are independent, so with a WorkerPool set they are rendered across its threads, each into its own mix buffer, and then added together
+    */
+    class FanBank
+    {
+    public:
+        using FloatVec = SimdUtils::FloatVec;
+
+        struct VoiceParameters
+        {
+            float speed{1.0f};       // speed of the fan (Hz)
+            float toneLevel{1.0f};   // level of the tone components (0-1)
+            float noiseLevel{1.0f};  // level of the noise components (0-1)
+            float stereoWidth{0.5f}; // pan modulation depth of the fan (0-1)
+            float gain{1.0f};        // level of the fan in the mix (0-1)
+            bool dopplerOn{false};   // doppler effect on the main blades noise
+        };
+
+        /**
+        Prepares the bank for playback, allocating the state of every voice
+        * @param _sampleRate - sample rate (Hz)
+        * @param _maxBlockSize - expected maximum number of samples per block, larger blocks are split up internally
+        * @param _maxVoices - most voices that will be used
+        */
+        void prepare(float _sampleRate, int _maxBlockSize, int _maxVoices);
+
+        /**
+        Sets how many voices are rendered, voices from numVoices up are silent and cost nothing
+        * @param numVoices - number of voices (0 to the maximum given to prepare())
+        */
+        void setNumVoices(int numVoices);
+
+        int getNumVoices() const { return numVoices; }
+
+        /**
+        Sets the parameters of one voice, speed and gain are smoothed and the other parameters change straight away
+        * @param voice - voice index (0 to the maximum given to prepare() - 1)
+        * @param params - new parameter values
+        */
+        void setVoiceParameters(int voice, const VoiceParameters &params);
+
+        /** Seeds the white noise generators, so renders of the same parameters are identical
+         * @param seed - seed value
+         */
+        void setSeed(uint64_t seed);
+
+        /** Sets how often the doppler cutoff of each voice is recalculated, the filter coefficient is interpolated in between
+         * @param numSamples - control interval in samples (at least 1)
+         */
+        void setControlInterval(int numSamples);
+
+        /**
+        Renders the groups of voices across the threads of a pool, for blocks of at least minBlockSize samples. Smaller blocks, and banks with a single group,
+        are rendered on the calling thread, as waking the workers would cost more than it saves. The output is the same either way
+        * @param pool - pool to render with, nullptr to render on the calling thread only. It must outlive the bank, or be replaced first
+        * @param minBlockSize - smallest block that is rendered in parallel (samples)
+        */
+        void setWorkerPool(WorkerPool *pool, int minBlockSize = defaultMinParallelBlockSize);
+
+        /** Clears the state of every voice, so processing starts again from silence. Speed and gain jump to their targets on the next block */
+        void reset();
+
+        /**
+        Renders a block of every voice mixed to stereo, overwriting the left and right buffers.
+        The output only depends on the parameters and the seed, not on how it is split into blocks
+        * @param left - buffer for the left channel out
+        * @param right - buffer for the right channel out
+        * @param numSamples - number of samples to process
+        */
+        void processBlock(float *left, float *right, int numSamples);
+
+        /**
+        Renders a block with the speed of every voice scaled each sample, so the bank can follow a motor envelope the same way a Machine drives FanPropeller.
+        The scale is used as it is, without the speed smoothing, so it should already be smoothed
+        * @param speedScale - speed of every voice as a multiple of its speed parameter, for each sample
+        * @param left - buffer for the left channel out
+        * @param right - buffer for the right channel out
+        * @param numSamples - number of samples to process
+        */
+        void processBlock(const float *speedScale, float *left, float *right, int numSamples);
+
+        static constexpr int chunkSize{64};                   // samples of noise generated for a group of voices at a time, so it fits on the stack
+        static constexpr int defaultMinParallelBlockSize{64}; // smallest block rendered across a WorkerPool unless setWorkerPool() is told otherwise
+
+    private:
+        /** processes a block of no more than maxBlockSize samples, speedScale is nullptr to smooth the speed of each voice to its target */
+        void processSubBlock(const float *speedScale, float *left, float *right, int numSamples);
+
+        /** Renders a block of one group of voices into the group's mix buffers, only touching the state of that group so groups can be rendered at the same time */
+        void renderGroup(size_t group, const float *speedScale, int numSamples);
+
+        /** returns the integrator gain coefficient of the state variable filter for each lane, tan(pi * cutoff / sampleRate) */
+        FloatVec cutoffToCoefficient(FloatVec cutoff) const;
+
+        static constexpr float pulseWidth{8.0f};         // pulse width of the blade tone
+        static constexpr float fixedCutoff{700.0f};      // cutoff of the noise filters when doppler is off (Hz)
+        static constexpr float fixedResonance{1.0f};     // resonance of the noise filters when doppler is off
+        static constexpr float dopplerRange{500.0f};     // range the blades sweep the doppler cutoff over (Hz)
+        static constexpr float dopplerOffset{100.0f};    // lowest doppler cutoff (Hz)
+        static constexpr float dopplerResonance{5.0f};   // resonance of the main blades filter with doppler on
+        static constexpr float fastBladesLevel{0.65f};   // level of the fast blades against the main blades
+        static constexpr float delayTimeInMs{200.0f};    // centre delay time of the fast blades (ms)
+        static constexpr float chopInMs{10.0f};          // modulation depth of the fast blades delay time (ms)
+        static constexpr float delayWetMix{0.33f};       // wet level of the fast blades delay
+        static constexpr float speedSmoothingInS{0.05f}; // seconds
+        static constexpr float gainSmoothingInS{0.1f};   // seconds
+
+        float sampleRate{44100.0f};      // Hz
+        int maxBlockSize{};              // samples allocated for the mix buffers by prepare()
+        int maxVoices{};                 // voices allocated by prepare()
+        int numVoices{};                 // voices being rendered
+        int controlInterval{16};         // samples between doppler cutoff updates
+        int samplesUntilControlUpdate{}; // samples remaining until the next doppler cutoff update
+        bool smoothersNeedReset{true};   // true until the first block after prepare() or reset(), when speed and gain jump to their targets
+
+        WorkerPool *workerPool{};                              // pool the groups are rendered across, nullptr to render on the calling thread
+        int minParallelBlockSize{defaultMinParallelBlockSize}; // smallest block rendered across workerPool (samples)
+
+        float speedSmoothing{};   // one pole smoothing coefficient for speed
+        float gainSmoothing{};    // one pole smoothing coefficient for gain
+        float fixedCoefficient{}; // filter coefficient for fixedCutoff
+
+        //============ voice parameters, one register for each group of voices ============//
+
+        std::vector<FloatVec> targetSpeed; // Hz
+        std::vector<FloatVec> targetGain;  // (0-1)
+        std::vector<FloatVec> toneLevel;   // (0-1)
+        std::vector<FloatVec> noiseLevel;  // (0-1)
+        std::vector<FloatVec> panWidth;    // (0-1)
+        std::vector<FloatVec> dopplerOn;   // 1 with doppler on, 0 with it off
+        std::vector<FloatVec> damping;     // 1 / resonance of the main blades filter
+
+        //============ voice state, one register for each group of voices ============//
+
+        std::vector<FloatVec> speed;                  // smoothed speed (Hz)
+        std::vector<FloatVec> gain;                   // smoothed gain
+        std::vector<FloatVec> phase;                  // blade phase (0-1)
+        std::vector<FloatVec> mainCoefficient;        // interpolated integrator gain of the main blades filter
+        std::vector<FloatVec> mainCoefficientStep;    // change of mainCoefficient each sample until the next control update
+        std::vector<FloatVec> mainState1, mainState2; // integrator states of the main blades filter
+        std::vector<FloatVec> fastState1, fastState2; // integrator states of the fast blades filter
+
+        std::vector<NoiseGenerator> noise; // one generator for each group, so each group uses its noise in time order
+        std::vector<FloatVec> delayBuffer; // fast blades delay lines, delaySize registers for each group with one voice in each lane
+        int delaySize{};                   // samples in each delay line, a power of two
+        int delayWritePos{};               // position the next sample is written to in every delay line
+
+        // mix of each group for the current block, maxBlockSize registers for each group with one voice in each lane.
+        // The groups are added together in order after they are all rendered, so the output does not depend on which threads rendered them
+        std::vector<FloatVec> groupMixLeft, groupMixRight;
+    };
+}
@@ -0,0 +1,104 @@
+/*
+  ==============================================================================
+
+    jr_FanSynth.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <PhysicalModellingFan/components/audio/jr_Machine.h>
+#include <vector>
+
+namespace jr
+{
+    /**
+    Plays a fixed pool of Machine voices from notes, so many fans can be played from a keyboard in one instance.
+    A note on powers a voice on, with its speed set by the note and its level by the velocity, and the note off powers it down again.
+    When every voice is busy the one with the lowest envelope is taken over. Voices that have powered down completely are skipped, so they cost nothing.
+    Use prepare() before use, then call noteOn() and noteOff() between calls to processBlock() at the sample each note is due
+    */
+    class FanSynth
+    {
+    public:
+        static constexpr int rootNote{60};      // note that plays at the speed set by the parameters (middle C)
+        static constexpr float minSpeed{0.25f}; // lowest speed a note can play at (Hz)
+        static constexpr float maxSpeed{60.0f}; // highest speed a note can play at (Hz)
+
+        /**
+        Prepares the synth for playback, allocating every voice and the scratch buffers used by processBlock()
+        * @param _sampleRate - sample rate (Hz)
+        * @param _maxBlockSize - expected maximum number of samples per block, larger blocks are split up internally
+        * @param numVoices - size of the voice pool, the most notes that sound at once
+        */
+        void prepare(float _sampleRate, int _maxBlockSize, int numVoices);
+
+        /**
+        Sets the parameters shared by every voice. Speed is the speed of rootNote and gain is the level at full velocity, power is ignored as the notes set it.
+        Call from the audio thread at the start of a block
+        * @param params - new parameter values
+        */
+        void setParameters(const MachineParameters &params);
+
+        /** Starts a note on a free voice, or on the voice with the lowest envelope when none are free. A note that is already playing restarts on its own voice
+         * @param note - MIDI note number (0-127)
+         * @param velocity - note velocity (0-1)
+         */
+        void noteOn(int note, float velocity);
+
+        /** Powers down the voice playing a note, if there is one
+         * @param note - MIDI note number (0-127)
+         */
+        void noteOff(int note);
+
+        /** Powers down every voice, each one fades out over the power down time */
+        void allNotesOff();
+
+        /**
+        Renders a block of every voice that is sounding mixed to stereo, overwriting the left and right buffers
+        * @param left - buffer for the left channel out
+        * @param right - buffer for the right channel out
+        * @param numSamples - number of samples to process
+        */
+        void processBlock(float *left, float *right, int numSamples);
+
+        /** Seeds the white noise generators of every voice, each voice gets its own seed from this one
+         * @param seed - seed value
+         */
+        void setSeed(uint64_t seed);
+
+        /** Returns true if a note on for the note has not been followed by a note off, and its voice has not been taken over */
+        bool isNoteHeld(int note) const;
+
+        /** Returns the number of voices that are sounding, held or still powering down */
+        int getNumActiveVoices() const;
+
+        /** Returns true when every voice has powered down completely, so processBlock() only clears the buffers */
+        bool isIdle() const { return getNumActiveVoices() == 0; }
+
+    private:
+        struct Voice
+        {
+            Machine machine;
+            int note{-1};           // note the voice was last started with, -1 before its first note
+            float velocity{};       // velocity the voice was last started with (0-1)
+            bool isHeld{false};     // true from note on until note off
+            juce::uint32 started{}; // value of noteCounter when the voice was started, to take over the oldest voice when envelopes are equal
+        };
+
+        /** Returns the voice to start a note on */
+        Voice &findVoiceForNote(int note);
+
+        /** Applies the shared parameters to a voice, with the speed, gain and power of its note */
+        void applyParameters(Voice &voice);
+
+        std::vector<Voice> voices;
+        MachineParameters sharedParameters{}; // parameters passed to the last call to setParameters()
+        juce::uint32 noteCounter{};           // incremented for every note on
+
+        int maxBlockSize{};
+        std::vector<float> voiceLeft;  // output of one voice for part of a block
+        std::vector<float> voiceRight; // output of one voice for part of a block
+    };
+}
@@ -3,9 +3,70 @@
 #include <PhysicalModellingFan/components/audio/jr_Motor_Envelope.h>
 #include <PhysicalModellingFan/components/audio/jr_SimpleFan.h>
 #include <PhysicalModellingFan/components/audio/jr_PolyBLEP_Oscillators.h>
+#include <optional>
+#include <vector>
 
 namespace jr
 {
+    /** Identifies a single parameter of the Machine, for parameter changes that are scheduled at a sample offset */
+    enum class MachineParameterId
+    {
+        gain = 0,
+        speed,
+        toneLevel,
+        noiseLevel,
+        stereoWidth,
+        powerUpTime,
+        powerDownTime,
+        dopplerOn,
+        powerOn
+    };
+
+    /**
+    A plain copy of every user facing parameter of the Machine, read from the host parameters at the start of each block and applied with Machine::setParameters()
+    */
+    struct MachineParameters
+    {
+        float gain{1.0f};          // master gain (0-1)
+        float speed{1.0f};         // max speed of the fan (Hz)
+        float toneLevel{1.0f};     // level of the fan tone components (0-1)
+        float noiseLevel{1.0f};    // level of the fan noise components (0-1)
+        float stereoWidth{0.5f};   // pan modulation depth of the fan (0-1)
+        float powerUpTime{1.5f};   // seconds
+        float powerDownTime{1.5f}; // seconds
+        bool dopplerOn{false};     // doppler effect on the main blades noise
+        bool powerOn{false};       // motor power
+
+        /** Sets one parameter by id
+         * @param id - parameter to set
+         * @param value - new value, bool parameters are on when the value is 0.5 or more
+         */
+        void set(MachineParameterId id, float value);
+
+        /**
+        Reads the parameters from a preset saved by the PresetManager, values missing from the preset keep the values already set
+        * @param xml - root element of the preset
+        */
+        void readPreset(const juce::XmlElement &xml);
+
+        /**
+        Reads the parameters from a preset file saved by the PresetManager, values missing from the preset keep the values already set
+        * @param file - preset file
+        */
+        juce::Result loadPreset(const juce::File &file);
+
+        /** Looks up the MachineParameterId for a plugin parameter ID (see ParameterIDs.h), or returns nothing if the Machine does not use that parameter */
+        static std::optional<MachineParameterId> getId(const juce::String &parameterId);
+    };
+
+    /** A change to one parameter at a sample offset within a block, bool parameters are on when the value is 0.5 or more */
+    struct MachineParameterEvent
+    {
+        int sampleOffset{}; // position in the block the change is applied at (samples)
+        MachineParameterId id{};
+        float value{};
+    };
+
     /*
     A class that contains all of the separate mechanical sound elements such as the fan and motor,
     as well as the shared elements such as envelope and speed controls.
@@ -17,17 +78,53 @@ namespace jr
     public:
         Machine() {}
 
-        void setSampleRate(float _sampleRate);
+        /**
+        Prepares the system for playback, allocating all of the scratch buffers used by processBlock()
+        * @param _sampleRate - sample rate (Hz)
+        * @param maxBlockSize - expected maximum number of samples per block, larger blocks are split up internally
+        */
+        void prepare(float _sampleRate, int maxBlockSize);
 
         /**
-        Processes the next sample values of the system. Call getCurrentSampleLeft and getCurrentSampleRight
-        to reference the new values.
+        Processes a block of samples of the system, overwriting the left and right buffers
+        * @param left - buffer for the left channel out
+        * @param right - buffer for the right channel out
+        * @param numSamples - number of samples to process
         */
-        void process();
+        void processBlock(float *left, float *right, int numSamples);
 
-        float getCurrentSampleLeft() { return currentSampleLeft; }
+        /**
+        Processes a block of samples of the system, splitting it at each parameter change so that every change lands on the sample it is scheduled for, whatever the block size
+        * @param left - buffer for the left channel out
+        * @param right - buffer for the right channel out
+        * @param numSamples - number of samples to process
+        * @param events - parameter changes sorted by sample offset, offsets outside of the block are applied at the start or end
+        * @param numEvents - number of parameter changes
+        */
+        void processBlock(float *left, float *right, int numSamples, const MachineParameterEvent *events, int numEvents);
 
-        float getCurrentSampleRight() { return currentSampleRight; }
+        /**
+        Applies a set of parameters, only the values that have changed since the last call are passed on to the components, so changes made with setParameter() in between are kept.
+        Call from the audio thread at the start of a block, every value is applied on the first call after prepare(), and power is only toggled when it changes
+        * @param params - new parameter values
+        */
+        void setParameters(const MachineParameters &params);
+
+        /**
+        Applies a single parameter change, power is only toggled when it changes and speed and gain are smoothed
+        * @param id - parameter to change
+        * @param value - new value, bool parameters are on when the value is 0.5 or more
+        */
+        void setParameter(MachineParameterId id, float value);
+
+        /**
+        Returns true when the motor is off and the envelope has fallen to 0. Every output sample is scaled by the envelope, so the machine is silent
+        and processBlock() only clears the buffers until it is powered on again
+        */
+        bool isIdle() const { return !envelope.getIsPowerOn() && envelope.getCurrentValue() <= 0.0f; }
+
+        /** Returns the current value of the motor envelope (0-1), which every output sample is scaled by */
+        float getEnvelopeValue() const { return envelope.getCurrentValue(); }
 
         void togglePower(bool powerOn) { powerOn ? envelope.powerOn() : envelope.powerOff(); }
 
@@ -38,19 +135,74 @@ namespace jr
 
         //================= Fan Mutators =================//
 
-        void setSpeed(float speedInHz) { fan.setSpeed(speedInHz); }
+        void setSpeed(float speedInHz) { maxSpeed.setTargetValue(speedInHz); }
         void setGain(float value) { gain.setTargetValue(value); }
         void setFanToneLevel(float level) { fan.setToneLevel(level); }
         void setFanNoiseLevel(float level) { fan.setNoiseLevel(level); }
         void setFanStereoWidth(float level) { fan.setPanWidth(level); }
         void setFanDoppler(bool isOn) { fan.setDopplerOn(isOn); }
 
+        /** Seeds the white noise generators of the fan, each instance is seeded randomly unless this is called
+         * @param seed - seed value, the same seed gives the same output for the same parameters
+         */
+        void setSeed(uint64_t seed) { fan.setSeed(seed); }
+
+        /** Sets how often the slowly changing fan signals (speed, doppler, delay time and pan) are recalculated, they are ramped in between
+         * @param numSamples - control interval in samples, 1 to update every sample
+         */
+        void setControlInterval(int numSamples) { fan.setControlInterval(numSamples); }
+
+        //================= Runtime State =================//
+
+        /** Returns the number of bytes saveState() writes, which only depends on the sample rate passed to prepare() */
+        size_t getStateSize() const;
+
+        /**
+        Copies the complete runtime state of the machine into a block of memory without allocating, for example to split a long offline render into chunks
+        or to seek without rendering from the start. The envelope, smoothed values, oscillator phases, filter and delay memory, noise generators and parameters
+        are all included, the scratch buffers are not. Call from the thread that calls processBlock()
+        * @param dest - memory to write the state into
+        * @param destSize - size of dest (bytes), at least getStateSize()
+        * @return false if dest is too small
+        */
+        bool saveState(void *dest, size_t destSize) const;
+
+        /**
+        Restores a state written by saveState() without allocating, after which processing is bit exact with the machine the state was saved from.
+        The machine must have been prepared at the same sample rate, the block size can be different. Call from the thread that calls processBlock()
+        * @param src - state written by saveState()
+        * @param srcSize - size of the state (bytes)
+        * @return false if the state does not match this machine or is damaged, in which case the machine is left as it was
+        */
+        bool restoreState(const void *src, size_t srcSize);
+
     private:
+        void setSampleRate(float _sampleRate);
+
+        /**
+        processes a block of no more than maxBlockSize samples, stopping early after the sample where the envelope falls to 0 with the power off
+        * @return number of samples processed
+        */
+        int processSubBlock(float *left, float *right, int maxSamples);
+
+        /** saves, restores or measures every part of the runtime state, in the same order for each */
+        void serialiseState(StateArchive &archive);
+
+        static constexpr juce::uint32 stateVersion{1}; // stored at the start of each state, increase when the layout of the state changes
+
         MachineEnvelope envelope{};
         FanPropeller fan{};
-        float currentSampleLeft{};
-        float currentSampleRight{};
         juce::SmoothedValue<float> gain;
         float gainSmoothingInS{0.1f};
+        juce::SmoothedValue<float> maxSpeed; // speed of the fan at full power (Hz)
+        float speedSmoothingInS{0.05f};
+
+        MachineParameters lastParameters{};  // parameters passed to the last call to setParameters()
+        bool parametersNeedFullUpdate{true}; // true until setParameters() has been called after prepare()
+        bool fanIsReset{false};              // true when the fan has been reset on becoming idle and has not been processed since
+
+        int maxBlockSize{};
+        std::vector<float> envelopeBuffer; // motor envelope value for each sample of the current block
+        std::vector<float> speedBuffer;    // current speed of the fan for each sample of the current block (Hz)
     };
 }
\ No newline at end of file
@@ -0,0 +1,99 @@
+/*
+  ==============================================================================
+
+    jr_MachineEventQueue.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <PhysicalModellingFan/components/audio/jr_Machine.h>
+#include <juce_core/juce_core.h>
+#include <array>
+
+namespace jr
+{
+    /**
+    A lock free single producer, single consumer list of parameter changes timestamped on the timeline in samples.
+    One thread schedules changes in time order with push(), and the audio thread collects the ones due in each block with popEventsForBlock(),
+    which turns them into sample offsets for Machine::processBlock() so they land on the same sample whatever the block size
+    */
+    class MachineEventQueue
+    {
+    public:
+        static constexpr int capacity{512}; // maximum number of changes waiting at once
+
+        /**
+        Schedules a parameter change, call from one thread only and in time order
+        * @param timeInSamples - position on the timeline the change is applied at (samples)
+        * @param id - parameter to change
+        * @param value - new value
+        * @return false if the queue is full and the change was dropped
+        */
+        bool push(juce::int64 timeInSamples, MachineParameterId id, float value)
+        {
+            const auto scope = fifo.write(1);
+
+            if (scope.blockSize1 + scope.blockSize2 == 0)
+                return false;
+
+            auto &event = events[static_cast<size_t>(scope.blockSize1 > 0 ? scope.startIndex1 : scope.startIndex2)];
+            event.timeInSamples = timeInSamples;
+            event.id = id;
+            event.value = value;
+
+            return true;
+        }
+
+        /**
+        Removes every change that is due before the end of a block, call from the audio thread only.
+        Changes that are already late are applied at the start of the block
+        * @param blockStartInSamples - timeline position of the first sample of the block (samples)
+        * @param numSamples - number of samples in the block
+        * @param out - array for the changes with their offsets in the block
+        * @param maxEvents - size of the out array
+        * @return number of changes written to out
+        */
+        int popEventsForBlock(juce::int64 blockStartInSamples, int numSamples, MachineParameterEvent *out, int maxEvents)
+        {
+            int numDue = 0;
+            int start1, size1, start2, size2;
+            fifo.prepareToRead(juce::jmin(maxEvents, fifo.getNumReady()), start1, size1, start2, size2);
+
+            auto collect = [&](int start, int size)
+            {
+                for (int i = start; i < start + size; i++)
+                {
+                    const auto &event = events[static_cast<size_t>(i)];
+                    const auto offset = event.timeInSamples - blockStartInSamples;
+
+                    if (offset >= numSamples)
+                        return false;
+
+                    out[numDue++] = {static_cast<int>(juce::jmax(offset, juce::int64{0})), event.id, event.value};
+                }
+
+                return true;
+            };
+
+            if (collect(start1, size1))
+                collect(start2, size2);
+
+            fifo.finishedRead(numDue);
+
+            return numDue;
+        }
+
+    private:
+        struct TimedEvent
+        {
+            juce::int64 timeInSamples{};
+            MachineParameterId id{};
+            float value{};
+        };
+
+        juce::AbstractFifo fifo{capacity};
+        std::array<TimedEvent, capacity> events{};
+    };
+}
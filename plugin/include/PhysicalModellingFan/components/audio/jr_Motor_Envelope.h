@@ -101,11 +101,39 @@ namespace jr
             return currentEnvValue;
         }
 
+        /** processes a block of the envelope, writing the envelope value for each sample
+         * @param out - buffer for the envelope values
+         * @param numSamples - number of samples to process
+         */
+        void processBlock(float *out, int numSamples)
+        {
+            for (int i = 0; i < numSamples; i++)
+                out[i] = process();
+        }
+
+        /** processes a block of the envelope like processBlock(), but stops after the sample where it falls to 0 with the power off
+         * @param out - buffer for the envelope values
+         * @param numSamples - most samples to process
+         * @return number of samples processed
+         */
+        int processBlockUntilSilent(float *out, int numSamples)
+        {
+            for (int i = 0; i < numSamples; i++)
+            {
+                out[i] = process();
+
+                if (!isOn && currentEnvValue <= 0.0f)
+                    return i + 1;
+            }
+
+            return numSamples;
+        }
+
         //================ accessors ================//
 
-        float getCurrentValue() { return currentEnvValue; }
+        float getCurrentValue() const { return currentEnvValue; }
 
-        bool getIsPowerOn() { return isOn; }
+        bool getIsPowerOn() const { return isOn; }
 
     private:
         float powerUpCurveGetNextValue()
@@ -0,0 +1,54 @@
+/*
+  ==============================================================================
+
+    jr_NoiseGenerator.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cstdint>
+
+namespace jr
+{
+    /**
+    A white noise generator that fills whole blocks at a time, using xoshiro128+ running on several independent lanes side by side.
+    The lane state is stored as structure-of-arrays, so each step of all lanes compiles to SIMD integer instructions.
+    Samples are consumed in order, so the output only depends on the seed and not on how it is split up into blocks.
+    Each instance is given a different seed by default, use setSeed() for reproducible output.
+    */
+    class NoiseGenerator
+    {
+    public:
+        NoiseGenerator();
+
+        /** Seeds the generator, lane states are expanded from the seed with splitmix64 so nearby seeds give unrelated sequences
+         * @param seed - seed value
+         */
+        void setSeed(uint64_t seed);
+
+        /** Fills a buffer with uniform white noise
+         * @param out - buffer to fill with values in the range 0-1 (0 inclusive, 1 exclusive)
+         * @param numSamples - number of samples to generate
+         */
+        void fillUniform(float *out, int numSamples);
+
+        /** Fills a buffer with approximately Gaussian white noise, using the sum of four uniform values (Irwin-Hall)
+         * @param out - buffer to fill with zero mean, unit variance values (bounded to +-3.46)
+         * @param numSamples - number of samples to generate
+         */
+        void fillGaussian(float *out, int numSamples);
+
+        static constexpr int numLanes{8}; // number of generators running side by side
+
+    private:
+        /** advances every lane by one step, writing one uniform value per lane */
+        void nextBatch(float *out);
+
+        uint32_t s0[numLanes]{}, s1[numLanes]{}, s2[numLanes]{}, s3[numLanes]{}; // xoshiro128+ state of each lane
+
+        float pending[numLanes]{}; // values from the last batch that have not been used yet
+        int numPending{};          // number of values left in pending, which are at the end of the array
+    };
+}
@@ -1,12 +1,14 @@
 #pragma once
 
-#include <cmath> // used for sin() and fabs() and std::fmod()
+#include <cstdint> // used for uint32_t phase accumulator
 
 namespace jr
 {
+	class StateArchive;
+
 	/** An Oscillator that can be set to either Sine, Sawtooth, Square, or Triangle mode.
 	Oscillator starts muted so use setMuted() to unmute, and use setSampleRate() before use
-	(static member so only needs to be set once for all instances)
+	Audio is rendered a block at a time by processNextBlock(), using a 32 bit fixed point phase accumulator and SIMD waveform kernels
 	* Derived from Martin Finke's Oscillator class from this tutorial: http://www.martin-finke.de/blog/articles/audio-plugins-018-polyblep-oscillator/
 	*/
 	class Oscillator
@@ -22,14 +24,13 @@ namespace jr
 
 		//==================== Constructors/Destructos =======================//
 
-		Oscillator() : oscMode(OscillatorMode::SINE), PI(2 * acos(0.0)), twoPI(2 * PI),
-					   isMuted(true), frequency(0.0), phase(0.0), phaseDelta(0.0) {}
+		Oscillator() : oscMode(OscillatorMode::SINE), frequency(0.0), isMuted(true) {}
 
-		~Oscillator() {}
+		virtual ~Oscillator() {}
 
 		//====================== Mutator Functions ===========================//
 
-		/** Sets the sample rate of all instances of Oscillator
+		/** Sets the sample rate of the Oscillator
 		 * @param sr - sample rate, Hz
 		 */
 		void setSampleRate(double sr);
@@ -55,7 +56,11 @@ namespace jr
 		 * Resets the Oscillator by setting the phase to 0
 		 * @return
 		 */
-		inline void reset() { phase = 0.0f; }
+		inline void reset()
+		{
+			phase = 0;
+			lastOutput = 0.0f;
+		}
 
 		/** Sets the phase shift amount of the oscillator, used to stagger phase of multiple oscillators
 		 * @param shiftAmount - phase shift amount (0-0.5)
@@ -63,57 +68,76 @@ namespace jr
 		inline void setPhaseShift(double shiftAmount)
 		{
 			if (shiftAmount <= 0 && shiftAmount <= 0.5)
-				phaseShift = shiftAmount;
+				phaseShift = static_cast<uint32_t>(static_cast<int64_t>(shiftAmount * phaseRange));
 		}
 
 		//======================= Accessor Functions =====================//
 
 		/**
-		 * Processes the Oscillator and returns the next sample value
+		 * Processes the Oscillator and returns the next sample value.
+		 * Convenience wrapper around processNextBlock(), prefer rendering whole blocks
 		 * @return sampleOut
 		 */
-		virtual float processSingleSample();
+		float processSingleSample();
 
 		/**
-		 * returns the next sample value for a naive waveform (unprotected from aliasing) according to a certain Oscillator Mode
-		 * @param mode - mode corresponding to waveform type i.e. SINE (or SQUARE/SAW/TRIANGLE)
-		 * @return value - next sample value for naive waveform
+		 * Processes a block of samples at the current frequency
+		 * @param buffer - buffer to read samples into
+		 * @param numSamples - buffer block size in samples
 		 */
-		double naiveWaveformForMode(OscillatorMode mode);
+		void processNextBlock(float *buffer, int numSamples);
 
 		/**
-		 * Processes a block of samples
+		 * Processes a block of samples, setting the frequency before each sample
 		 * @param buffer - buffer to read samples into
+		 * @param frequencies - frequency for each sample, Hz (values <= 0 keep the previous frequency, as with setFrequency())
 		 * @param numSamples - buffer block size in samples
 		 */
-		void processNextBlock(float *buffer, int numSamples);
+		void processNextBlock(float *buffer, const float *frequencies, int numSamples);
+
+		/**
+		 * Saves or restores the phase, frequency and every other setting of the Oscillator
+		 * @param archive - archive to save into or restore from
+		 */
+		void serialiseState(StateArchive &archive);
 
 	protected:
+		/**
+		 * Returns true if the waveform kernels should apply polyBLEP anti-aliasing to the SAW, SQUARE and TRIANGLE modes
+		 */
+		virtual bool isAntiAliased() const { return false; }
+
 		//============== params ===============//
 
-		static double sampleRate; // Hz
+		double sampleRate{44100}; // Hz
 		OscillatorMode oscMode;	  // mode determining waveform type
 		double frequency;		  // Hz
-		double phase;
-		double phaseDelta;
-		bool isMuted;		 // true when Oscillator is muted
-		double phaseShift{}; // phase shift amount, used to stagger phase of multiple instances (0-0.5)
+		uint32_t phase{};		  // current phase as 0.32 fixed point, wraps around naturally at 1
+		uint32_t phaseIncrement{}; // phase increment per sample as 0.32 fixed point
+		bool isMuted;			  // true when Oscillator is muted
+		uint32_t phaseShift{};	  // phase shift amount as 0.32 fixed point, used to stagger phase of multiple instances (0-0.5)
+		float lastOutput{};		  // last sample value to be output, used for the leaky integrator of the triangle wave
 
 		//================= constants =============//
 
-		const double PI;	// mathematical constant pi
-		const double twoPI; // two * mathematical constant pi
+		static constexpr double phaseRange{4294967296.0}; // 2^32, the range of the fixed point phase accumulator
 
 		//================= functions =============//
 
 		/**
-		 * updates the phaseDelta value, called each time sampleRate or frequency is updated
+		 * updates the phaseIncrement value, called each time sampleRate or frequency is updated
 		 * @return
 		 */
 		void updatePhaseDelta()
 		{
-			phaseDelta = frequency / sampleRate;
+			phaseIncrement = static_cast<uint32_t>(frequency * (phaseRange / sampleRate));
 		}
+
+	private:
+		/**
+		 * Renders a block of no more than one kernel chunk, phase accumulation runs first and is followed by the SIMD waveform kernel
+		 */
+		void renderChunk(float *buffer, const float *frequencies, int numSamples);
 	};
 
 	/** An Oscillator that uses the polyBLEP algorithm for anti-aliasing
@@ -121,27 +145,7 @@ namespace jr
 	 */
 	class polyblepOscillator : public Oscillator
 	{
-	public:
-		//======================= Accessor Functions =====================//
-
-		/**
-		 * Processes the Oscillator and returns the next sample value
-		 * @return sampleOut
-		 */
-		float processSingleSample() override;
-
-	private:
-		//============= parameters ============//
-
-		float lastOutput{}; // last sample value to be output, used for triangle wave BLEP
-
-		//============== functions ============//
-
-		/**
-		 * Checks the current phase and returns a sample adjustment amount based on polyBLEP antialiasing algorithm
-		 * @param t - phase (0-1)
-		 * @return adjustment - sample adjustment amount
-		 */
-		double polyBLEP(double t);
+	protected:
+		bool isAntiAliased() const override { return true; }
 	};
-}
\ No newline at end of file
+}
@@ -0,0 +1,45 @@
+/*
+  ==============================================================================
+
+    jr_PulseShaper.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+// 1 to use a hardware reciprocal estimate refined by one Newton-Raphson step in the pulse shaper, 0 to use an exact division
+#ifndef JR_FAST_RECIPROCAL
+#define JR_FAST_RECIPROCAL 1
+#endif
+
+namespace jr
+{
+    /**
+    Block waveshaping kernel that turns a sine wave into the narrow pulse used by the fan blade tone, using 1/(1 + (x * pulseWidth)^2)
+    */
+    class PulseShaper
+    {
+    public:
+        /**
+        Shapes a block of sine wave into a narrow pulse, using the reciprocal selected by JR_FAST_RECIPROCAL
+        * @param sineIn - sine wave in (-1 to 1)
+        * @param pulseWidth - pulse width, higher values give a narrower pulse
+        * @param level - volume level applied to out
+        * @param rawSignalOut - buffer for the pulse before the level has been applied
+        * @param out - buffer for the pulse with the level applied
+        * @param numSamples - number of samples to process
+        */
+        static void process(const float *sineIn, float pulseWidth, float level, float *rawSignalOut, float *out, int numSamples)
+        {
+            processWith<JR_FAST_RECIPROCAL != 0>(sineIn, pulseWidth, level, rawSignalOut, out, numSamples);
+        }
+
+        /**
+        Same as process(), with the reciprocal chosen by the template argument.
+        The fast reciprocal has a relative error below 2.5e-7 on x86 (12 bit estimate) and around 1.5e-5 on ARM NEON (8 bit estimate)
+        */
+        template <bool useFastReciprocal>
+        static void processWith(const float *sineIn, float pulseWidth, float level, float *rawSignalOut, float *out, int numSamples);
+    };
+}
@@ -12,14 +12,124 @@
 
 #include <PhysicalModellingFan/components/audio/jr_PolyBLEP_Oscillators.h> // used for jr::polyblepOscillator class
 #include <PhysicalModellingFan/components/audio/jr_Delay.h>                // used for FractionalDelay class
+#include <PhysicalModellingFan/components/audio/jr_PulseShaper.h>          // used for PulseShaper class
+#include <PhysicalModellingFan/components/audio/jr_NoiseGenerator.h>       // used for NoiseGenerator class
+#include <PhysicalModellingFan/components/audio/jr_ControlRateRamp.h>      // used for ControlRateRamp class
+#include <PhysicalModellingFan/utils/jr_StateArchive.h>                    // used for StateArchive class
 #include <juce_audio_basics/juce_audio_basics.h>
 #include <juce_core/juce_core.h>
+#include <vector>
 
 namespace jr
 {
 
+    /** A topology-preserving transform (TPT) state variable filter, based on Andrew Simper's (Cytomic) SVF.
+    Band-pass and low-pass outputs are produced by the same state update, and the filter stays well behaved
+    when its cutoff is modulated every sample, unlike a direct form biquad.
+    Use setSampleRate() before use, then setParams() to set the cutoff and resonance.
+    */
+    class StateVariableFilter
+    {
+    public:
+        //================================= mutator ===================================//
+
+        /** Sets the sample rate, call setParams() afterwards to recalculate the coefficient
+         * @param sr - sample rate (Hz)
+         */
+        void setSampleRate(float sr) { sampleRate = sr; }
+
+        /** Sets the cutoff frequency and resonance of the filter
+         * @param cutoff - cutoff frequency (Hz)
+         * @param q - resonance value
+         */
+        void setParams(float cutoff, float q)
+        {
+            setResonance(q);
+            setCoefficient(cutoffToCoefficient(cutoff));
+        }
+
+        /** Sets the resonance of the filter, which is applied the next time the coefficient is set
+         * @param q - resonance value
+         */
+        void setResonance(float q)
+        {
+            if (q > 0)
+                k = 1.0f / q;
+        }
+
+        /** Sets the integrator gain coefficient directly, used to sweep the cutoff without recalculating tan() every sample
+         * @param gIn - integrator gain coefficient, see cutoffToCoefficient()
+         */
+        void setCoefficient(float gIn)
+        {
+            g = gIn;
+            a1 = 1.0f / (1.0f + g * (g + k));
+            a2 = g * a1;
+            a3 = g * a2;
+        }
+
+        /** Clears the filter state
+         */
+        void reset()
+        {
+            ic1eq = 0.0f;
+            ic2eq = 0.0f;
+        }
+
+        //================================= accessor ===================================//
+
+        /** Returns the integrator gain coefficient for a cutoff frequency, tan(pi * cutoff / sampleRate).
+         * The cutoff is limited to 0.45 * sampleRate, where fastTan() stays accurate
+         * @param cutoff - cutoff frequency (Hz)
+         * @return g - integrator gain coefficient
+         */
+        float cutoffToCoefficient(float cutoff) const
+        {
+            float limitedCutoff = juce::jlimit(0.0f, 0.45f * sampleRate, cutoff);
+            return fastTan(juce::MathConstants<float>::pi * limitedCutoff / sampleRate);
+        }
+
+        /** returns the current integrator gain coefficient */
+        float getCoefficient() const { return g; }
+
+        /** Processes a single sample through the filter
+         * @param in - sample value in
+         * @param bandPass - band-pass output, normalised to unity gain at the cutoff frequency
+         * @param lowPass - low-pass output
+         */
+        void processSample(float in, float &bandPass, float &lowPass)
+        {
+            float v3 = in - ic2eq;
+            float v1 = a1 * ic1eq + a2 * v3;
+            float v2 = ic2eq + a2 * ic1eq + a3 * v3;
+
+            ic1eq = 2.0f * v1 - ic1eq;
+            ic2eq = 2.0f * v2 - ic2eq;
+
+            bandPass = k * v1;
+            lowPass = v2;
+        }
+
+        /** Rational (Pade 5/4) approximation of tan(x) for 0 <= x < pi/2.
+         * Relative error is below 3e-7 up to pi/4 (cutoff of sampleRate/4), and below 1e-4 up to 1.5 (0.477 * sampleRate)
+         * @param x - angle (radians)
+         */
+        static float fastTan(float x)
+        {
+            float x2 = x * x;
+            return x * (945.0f - 105.0f * x2 + x2 * x2) / (945.0f - 420.0f * x2 + 15.0f * x2 * x2);
+        }
+
+    private:
+        float sampleRate{44100.0f}; // sample rate (Hz)
+        float g{};                  // integrator gain coefficient, tan(pi * cutoff / sampleRate)
+        float k{1.0f};              // damping coefficient, 1 / resonance
+        float a1{}, a2{}, a3{};     // coefficients derived from g and k
+        float ic1eq{}, ic2eq{};     // integrator states
+    };
+
     /** A class that models the toned component of a simple Propeller Fan Physical Model.
-    Use setSampleRate() before use. Call process() each sample to get audio out.
+    Use setSampleRate() before use. Call processBlock() each block to get audio out.
     */
     class FanToneComponent
     {
@@ -61,44 +171,55 @@ namespace jr
                 level = vol;
         }
 
-        //================================= accessor ===================================//
+        /** Resets the oscillator to the start of its cycle */
+        void reset() { sineOsc.reset(); }
 
-        /** returns the current sample value for the raw sine wave before it has been transformed into the tone, used to control other connected components
-         * @return rawSineSignal - current sample value of raw sine signal
+        /** Saves or restores the oscillator and settings of the component
+         * @param archive - archive to save into or restore from
          */
-        float getRawSine() { return rawSineSignal; }
+        void serialiseState(StateArchive &archive);
 
-        /** returns the current sample value for the output audio signal before the volume level has been applied, used to send to noise component
-         * @return rawSignal - current sample value for the raw audio output signal
-         */
-        float getRawSignal() { return rawSignal; }
+        //================================= process ===================================//
 
-        /** Processes the tone component and returns the next sample value for the audio signal
-         * @return sampleOut - next sample value for audio signal out
+        /** Processes a block of the tone component
+         * @param speedIn - speed of the fan for each sample (Hz)
+         * @param rawSineOut - buffer for the raw sine signal before it has been transformed into the tone, used to control other connected components
+         * @param rawSignalOut - buffer for the output audio signal before the volume level has been applied, used to send to a noise component
+         * @param out - buffer for the audio signal out
+         * @param numSamples - number of samples to process
          */
-        float process();
+        void processBlock(const float *speedIn, float *rawSineOut, float *rawSignalOut, float *out, int numSamples);
 
     private:
         polyblepOscillator sineOsc; // sine oscillator used as base of the tone component
         float phaseShift{};         // amount of phase shift (0-0.5), used to stagger phase of multiple instances
         float pulseWidth{8.0};      // pulse width of waveform
         float level{1.0f};          // volume level of tone component (0-1)
-        float rawSineSignal{};      // current sample value for the raw sine signal, used to control delay or doppler components that may be connected
-        float rawSignal{};          // current sample value for the output audio signal before the volume level has been applied, used to send to an attached noise component
     };
 
     /** A class that models the noise component of a simple Propeller Fan Physical Model.
-    Use setSampleRate() before use. Call process() each sample to get audio out.
+    Use setSampleRate() before use. Call processBlock() each block to get audio out.
     */
     class FanNoiseComponent
     {
     public:
+        static constexpr size_t bandPassType{0}; // filter type index of the band pass output
+        static constexpr size_t lowPassType{1};  // filter type index of the low pass output
+
         //================================= mutator ===================================//
 
         /** Sets the sample rate of the component
          * @param sr - sample rate (Hz)
          */
-        void setSampleRate(float sr) { sampleRate = sr; }
+        void setSampleRate(float sr)
+        {
+            if (sr != sampleRate)
+            {
+                sampleRate = sr;
+                filter.setSampleRate(sr);
+                coefficientsNeedUpdate = true;
+            }
+        }
 
         /** Sets the volume level of the component
          * @param gain - volume level (0-1)
@@ -116,31 +237,67 @@ namespace jr
          */
         void setFilterType(size_t typeIndex)
         {
-            if (typeIndex == 0 || typeIndex == 1)
+            if (typeIndex == bandPassType || typeIndex == lowPassType)
                 filterType = typeIndex;
         }
 
-        //================================= accessor ===================================//
+        /** Seeds the white noise generator so the output is reproducible
+         * @param seed - seed value
+         */
+        void setSeed(uint64_t seed) { noise.setSeed(seed); }
 
-        /** returns the next sample value for the noise component
+        /** Clears the filter state */
+        void reset() { filter.reset(); }
+
+        /** Saves or restores the filter, the noise generator and the settings of the component
+         * @param archive - archive to save into or restore from
+         */
+        void serialiseState(StateArchive &archive);
+
+        //================================= process ===================================//
+
+        /** Processes a block of the noise component
          * @param rawSignalIn - raw signal from attached tone component
-         * @return sampleOut - next sample value
+         * @param out - buffer for the audio signal out
+         * @param numSamples - number of samples to process
          */
-        virtual float process(float rawSignalIn);
+        void processBlock(const float *rawSignalIn, float *out, int numSamples);
 
     protected:
-        float cutoff{700.0f};   // cutoff frequency of filter (Hz)
-        float resonance{1.0f};  // resonance (Q value) of filter
-        juce::IIRFilter filter; // filter
-        float sampleRate{};     // sample rate of component (Hz)
-        juce::Random random;    // random number generator for white noise
-        float level{1.0f};      // volume level of nosie component (0-1)
-        size_t filterType{};    // filter type index (0=BandPass, 1=LowPass)
+        /** Returns the output of the filter for a filter type chosen at compile time
+         * @param in - sample value in
+         */
+        template <size_t type>
+        float filterSample(float in)
+        {
+            float bandPass, lowPass;
+            filter.processSample(in, bandPass, lowPass);
+
+            if constexpr (type == lowPassType)
+                return lowPass;
+            else
+                return bandPass;
+        }
+
+        float cutoff{700.0f};              // cutoff frequency of filter (Hz)
+        float resonance{1.0f};             // resonance (Q value) of filter
+        StateVariableFilter filter;        // filter
+        bool coefficientsNeedUpdate{true}; // true when cutoff, resonance or sample rate have changed since the filter coefficient was last calculated
+        float sampleRate{};                // sample rate of component (Hz)
+        NoiseGenerator noise;              // block white noise generator
+        float level{1.0f};                 // volume level of nosie component (0-1)
+        size_t filterType{};               // filter type index (0=BandPass, 1=LowPass)
+
+    private:
+        /** Filters the white noise in the out buffer and applies the raw signal and level, specialised for each filter type */
+        template <size_t type>
+        void renderNoise(const float *rawSignalIn, float *out, int numSamples);
     };
 
     /** A type of noise component class for a simple fan, where a doppler effect is created with the filter using a control signal
-    Use setSampleRate() before use. Call process() each sample to get audio out. setDoppler() turns doppler on or off.
+    Use setSampleRate() before use. Call processBlock() each block to get audio out. setDoppler() turns doppler on or off.
     setFilterParams() can be used to set the parameters for the noise component when dopper is turned OFF, for filter parameters that will be controlled by doppler use setDopplerParams()
+    The doppler cutoff is only calculated once every control interval (see setControlInterval()) and the filter coefficient is ramped linearly in between
     */
     class FanDopplerComponent : public FanNoiseComponent
     {
@@ -160,22 +317,47 @@ namespace jr
          */
         void setDopplerOn(bool isOn) { dopplerOn = isOn; }
 
-        /** Returns the next sample value for the noise component - affected by doppler affect if doppler is on, and not if it is off
+        /** Sets how often the doppler cutoff is recalculated from the control signal
+         * @param numSamples - control interval in samples, the filter coefficient is ramped between updates
+         */
+        void setControlInterval(int numSamples) { dopplerCoefficient.setInterval(numSamples); }
+
+        /** Clears the filter state, the doppler cutoff is jumped to on the next block */
+        void reset()
+        {
+            FanNoiseComponent::reset();
+            dopplerCoefficient.reset();
+        }
+
+        /** Saves or restores the noise component along with the doppler settings and the current doppler coefficient
+         * @param archive - archive to save into or restore from
+         */
+        void serialiseState(StateArchive &archive);
+
+        /** Processes a block of the noise component - affected by doppler affect if doppler is on, and not if it is off
          * @param rawSignalIn - raw signal from attached tone component
-         * @return sampleOut - next sample value
+         * @param controlSignalIn - control signal used to modulate the cutoff frequency
+         * @param out - buffer for the audio signal out
+         * @param numSamples - number of samples to process
          */
-        float process(float rawSignalIn) override;
+        void processBlock(const float *rawSignalIn, const float *controlSignalIn, float *out, int numSamples);
 
     private:
+        /** Filters the white noise in the out buffer with the doppler cutoff, specialised for each filter type */
+        template <size_t type>
+        void renderDoppler(const float *rawSignalIn, const float *controlSignalIn, float *out, int numSamples);
+
         float cutoffRange{500.0f};   // range of modulation of cutoff frequency (Hz)
         float cutoffOffset{100.0f};  // offset of cutoff frequency (Hz)
         float dopplerCutoff{700.0f}; // current cutoff frequency resulting from doppler modulation (Hz)
         float dopplerRes{5.0f};      // current resonance value for filter with doppler effect
         bool dopplerOn{true};        // doppler effect on/off
+
+        ControlRateRamp dopplerCoefficient; // filter coefficient for the doppler cutoff, ramped between control updates
     };
 
     /** A specific delay class used to create a fast blade effect for a Fan Physical Model by varying the delay length of a delay line at a set rate
-    Use setSampleRate() before use. Call process() each sample for output.
+    Use setSampleRate() before use. Call processBlock() each block for output.
     */
     class FanDelay
     {
@@ -194,20 +376,40 @@ namespace jr
                 chop = chopIn;
         }
 
-        /** processes the new delay length according to the control signal, and then processes the audioSignalIn, returning a mix of the dry and delayed signal
-         * @param controlSignalIn - current sample value for the control signal
-         * @param audioSignalIn - current sample value for the dry audio signal
+        /** Sets how often the delay time is recalculated from the control signal
+         * @param numSamples - control interval in samples, the delay time is ramped between updates
          */
-        float process(float controlSignalIn, float audioSignalIn);
+        void setControlInterval(int numSamples) { delayTime.setInterval(numSamples); }
+
+        /** Clears the delay line, the delay time is jumped to on the next block */
+        void reset()
+        {
+            delayLine.clearBuffer();
+            delayTime.reset();
+        }
+
+        /** Saves or restores the delay time and the part of the delay line that can still be read, the sample rate must match the saved one
+         * @param archive - archive to save into or restore from
+         */
+        void serialiseState(StateArchive &archive);
+
+        /** processes the new delay length according to the control signal for each sample, and then processes the audioSignalIn, writing a mix of the dry and delayed signal
+         * @param controlSignalIn - control signal
+         * @param audioSignalIn - dry audio signal
+         * @param out - buffer for the mixed signal out, can be the same as audioSignalIn
+         * @param numSamples - number of samples to process
+         */
+        void processBlock(const float *controlSignalIn, const float *audioSignalIn, float *out, int numSamples);
 
     private:
         float chop{10.0f};         // modulation depth of the delay length in ms (0-99.9)
         float sampleRate{};        // sample rate, Hz
         FractionalDelay delayLine; // delay line
+        ControlRateRamp delayTime; // delay time in samples, ramped between control updates
     };
 
     /** A simple stereo panner class that takes a signal value in and uses it to oscillate panning position around centre to a set pan width amount
-    Use setPanWidth() before use. Call process() each sample to calculate new pan values, and then use getLeft() and getRight() to access volume levels for each channel.
+    Use setPanWidth() before use. Call processBlock() each block to pan a mono signal into the left and right channels.
     */
     class FanPanner
     {
@@ -221,25 +423,31 @@ namespace jr
                 panWidth = width;
         }
 
-        /** calculates new pan values for stereo channels using an input current sample value of a control signal
-         * @param controlSignalIn - current sample value for control signal
+        /** Sets how often the pan position is recalculated from the control signal
+         * @param numSamples - control interval in samples, the channel levels are ramped between updates
          */
-        void process(float controlSignalIn);
+        void setControlInterval(int numSamples) { rightLevel.setInterval(numSamples); }
+
+        /** Forgets the current pan position, it is jumped to on the next block */
+        void reset() { rightLevel.reset(); }
 
-        /** Returns the volume level for the left channel
-         * @param leftLevel - volume level for left channel (0-1)
+        /** Saves or restores the pan width and position
+         * @param archive - archive to save into or restore from
          */
-        float getLeft() { return leftLevel; }
+        void serialiseState(StateArchive &archive) { archive(panWidth, rightLevel); }
 
-        /** Returns the volume level for the right channel
-         * @param rightLevel - volume level for right channel (0-1)
+        /** calculates new pan values for stereo channels using the control signal, and applies them to the mono signal in
+         * @param controlSignalIn - control signal
+         * @param monoIn - mono signal to be panned
+         * @param leftOut - buffer for the left channel out
+         * @param rightOut - buffer for the right channel out, must not be the same as monoIn
+         * @param numSamples - number of samples to process
          */
-        float getRight() { return rightLevel; }
+        void processBlock(const float *controlSignalIn, const float *monoIn, float *leftOut, float *rightOut, int numSamples);
 
     private:
-        float panWidth{};   // width/depth of panning modulation around centre (0-1)
-        float leftLevel{};  // volume level for left channel
-        float rightLevel{}; // volume level for right channel
+        float panWidth{};           // width/depth of panning modulation around centre (0-1)
+        ControlRateRamp rightLevel; // level of the right channel, ramped between control updates (the left level is 1 - rightLevel)
     };
 
     class MainBlades
@@ -249,6 +457,11 @@ namespace jr
 
         void setSampleRate(float _sampleRate);
 
+        /** Allocates the scratch buffers used by processBlock()
+         * @param maxBlockSize - maximum number of samples that will be passed to processBlock()
+         */
+        void setMaxBlockSize(int maxBlockSize);
+
         /** sets the volume value for the tone component of the main blades
          * @param vol - volume level (0-1)
          */
@@ -264,27 +477,51 @@ namespace jr
          */
         void setDopplerOn(bool isOn) { noiseComp.setDopplerOn(isOn); }
 
-        /** Updates the doppler effected noise components cutoff frequency value using the raw sine signal from the main blades tone comp as a control signal
-         * @return
+        void setPulseWidth(float pw) { toneComp.setPulseWidth(pw); }
+
+        /** Seeds the white noise generator of the noise component so the output is reproducible
+         * @param seed - seed value
          */
-        void setDopplerParams() { noiseComp.setDopplerParams(toneComp.getRawSine()); }
+        void setSeed(uint64_t seed) { noiseComp.setSeed(seed); }
 
-        void setSpeed(float speedInHz) { toneComp.setSpeed(speedInHz); }
+        /** Sets how often the doppler cutoff is recalculated from the control signal
+         * @param numSamples - control interval in samples
+         */
+        void setControlInterval(int numSamples) { noiseComp.setControlInterval(numSamples); }
 
-        void setPulseWidth(float pw) { toneComp.setPulseWidth(pw); }
+        /** Resets the state of the tone and noise components */
+        void reset()
+        {
+            toneComp.reset();
+            noiseComp.reset();
+        }
 
-        /** processes the next mono sample value for the main blades
+        /** Saves or restores the level and the state of the tone and noise components, the scratch buffers are not included
+         * @param archive - archive to save into or restore from
          */
-        float process();
+        void serialiseState(StateArchive &archive);
 
-        /** returns the raw signal value from the tone component to be used for controlling a panning component
+        /** processes a block of mono samples for the main blades
+         * @param speedIn - speed of the fan for each sample (Hz)
+         * @param out - buffer for the mono signal out
+         * @param numSamples - number of samples to process, no more than the max block size
          */
-        float getPanControlSignal() { return toneComp.getRawSine(); }
+        void processBlock(const float *speedIn, float *out, int numSamples);
+
+        /** returns the raw sine signal from the tone component for the last processed block, to be used for controlling a panning component
+         */
+        const float *getPanControlSignal() const { return rawSineBuffer.data(); }
 
     private:
         float level{1.0f};
         FanToneComponent toneComp{};     // tone component of main blades
         FanDopplerComponent noiseComp{}; // noise component of main blades with doppler capabilities
+
+        //============ scratch buffers ============//
+
+        std::vector<float> rawSineBuffer;   // raw sine signal of the tone component, used as the doppler and pan control signal
+        std::vector<float> rawSignalBuffer; // raw tone signal before its level is applied, sent to the noise component
+        std::vector<float> noiseBuffer;     // output of the noise component
     };
 
     class FastBlades
@@ -294,7 +531,17 @@ namespace jr
 
         void setSampleRate(float _sampleRate);
 
-        float process();
+        /** Allocates the scratch buffers used by processBlock()
+         * @param maxBlockSize - maximum number of samples that will be passed to processBlock()
+         */
+        void setMaxBlockSize(int maxBlockSize);
+
+        /** processes a block of mono samples for the fast blades
+         * @param speedIn - speed of the fan for each sample (Hz)
+         * @param out - buffer for the mono signal out
+         * @param numSamples - number of samples to process, no more than the max block size
+         */
+        void processBlock(const float *speedIn, float *out, int numSamples);
 
         /** Sets the chop value for the delay component, which is the modulation depth of the delay length
          * @param chop - modulation depth of the delay length (ms)
@@ -313,21 +560,45 @@ namespace jr
          */
         void setNoiseLevel(float vol) { noiseComp.setLevel(vol); }
 
-        /** Sets the speed of the fan in Hz
-         * @param speedInHz
-         */
-        void setSpeed(float speedInHz) { toneComp.setSpeed(speedInHz); }
-
         /** Sets the pulse width of the tone components
          * @param pw - pulse width
          */
         void setPulseWidth(float pw) { toneComp.setPulseWidth(pw); }
 
+        /** Seeds the white noise generator of the noise component so the output is reproducible
+         * @param seed - seed value
+         */
+        void setSeed(uint64_t seed) { noiseComp.setSeed(seed); }
+
+        /** Sets how often the delay time is recalculated from the control signal
+         * @param numSamples - control interval in samples
+         */
+        void setControlInterval(int numSamples) { delayComp.setControlInterval(numSamples); }
+
+        /** Resets the state of the tone, noise and delay components */
+        void reset()
+        {
+            toneComp.reset();
+            noiseComp.reset();
+            delayComp.reset();
+        }
+
+        /** Saves or restores the level and the state of the tone, noise and delay components, the scratch buffers are not included
+         * @param archive - archive to save into or restore from
+         */
+        void serialiseState(StateArchive &archive);
+
     private:
         float level{0.65f};
         FanToneComponent toneComp{};   // tone component of fast blades
         FanNoiseComponent noiseComp{}; // noise component of fast blades
         FanDelay delayComp{};          // delay component of fast blades
+
+        //============ scratch buffers ============//
+
+        std::vector<float> rawSineBuffer;   // raw sine signal of the tone component, used as the delay control signal
+        std::vector<float> rawSignalBuffer; // raw tone signal before its level is applied, sent to the noise component
+        std::vector<float> noiseBuffer;     // output of the noise and delay components
     };
 
     class FanPropeller
@@ -342,13 +613,10 @@ namespace jr
          */
         void setSampleRate(float sr);
 
-        /** Sets the max speed of the fan in Hz
-         * @param speedInHz
+        /** Allocates the scratch buffers used by processBlock()
+         * @param maxBlockSize - maximum number of samples that will be passed to processBlock()
          */
-        void setSpeed(float speedInHz)
-        {
-            maxSpeed = speedInHz;
-        };
+        void setMaxBlockSize(int maxBlockSize);
 
         /** Sets the pulse width of the tone components
          * @param pw - pulse width
@@ -370,11 +638,6 @@ namespace jr
          */
         void setDopplerOn(bool isOn) { mainBlades.setDopplerOn(isOn); }
 
-        /** Updates the doppler effected noise components cutoff frequency value using the raw sine signal from the main blades tone comp as a control signal
-         * @return
-         */
-        void setDopplerParams() { mainBlades.setDopplerParams(); }
-
         void setMainBladesLevel(float vol) { mainBlades.setLevel(vol); }
         void setFastBladesLevel(float vol) { fastBlades.setLevel(vol); }
 
@@ -402,29 +665,38 @@ namespace jr
          */
         void setFastNoiseLevel(float vol) { fastBlades.setNoiseLevel(vol); }
 
-        /** processes the next sample values for the fans left and right channels
+        /** Seeds the white noise generators of the main and fast blades, which are given different sequences
+         * @param seed - seed value
          */
-        void process(float envelope);
+        void setSeed(uint64_t seed)
+        {
+            mainBlades.setSeed(seed);
+            fastBlades.setSeed(seed + 1);
+        }
+
+        /** Sets how often the slowly changing signals (speed, doppler cutoff, delay time and pan position) are recalculated,
+         * they are ramped linearly in between. An interval of 1 updates them every sample
+         * @param numSamples - control interval in samples (e.g. 8, 16 or 32)
+         */
+        void setControlInterval(int numSamples);
 
-        //============================ accessors ============================//
+        /** Resets the state of every component, so processing can start again from silence */
+        void reset();
 
-        /** returns the current sample value for the left channel of the fan
-         * @return sampleOut
+        /** Saves or restores the state of every component, so processing carries on exactly where the saved fan left off
+         * @param archive - archive to save into or restore from
          */
-        float getLeftSample() { return currentLeftSample; }
+        void serialiseState(StateArchive &archive);
 
-        /** returns the current sample value for the right channel of the fan
-         * @return sampleOut
+        /** processes a block of samples for the fans left and right channels
+         * @param speedIn - speed of the fan for each sample (Hz), only read at control rate
+         * @param leftOut - buffer for the left channel out
+         * @param rightOut - buffer for the right channel out
+         * @param numSamples - number of samples to process, no more than the max block size
          */
-        float getRightSample() { return currentRightSample; }
+        void processBlock(const float *speedIn, float *leftOut, float *rightOut, int numSamples);
 
     private:
-        /** Sets the current speed of the fan tone and noise components in Hz
-        Used to set the current value based on the maxSpeed and current envelope value
-        * @param speedInHz
-        */
-        void setCurrentSpeed(float speedInHz);
-
         FanPanner pannerComp{}; // panning component for whole system (controlled by main blades)
         MainBlades mainBlades{};
         FastBlades fastBlades{};
@@ -433,8 +705,12 @@ namespace jr
 
         bool hasInit{false};
 
-        float maxSpeed{};           // max speed in Hz
-        float currentLeftSample{};  // current sample value for left channel
-        float currentRightSample{}; // current sample value for right channel
+        ControlRateRamp speed; // current speed of the fan in Hz, ramped between control updates
+
+        //============ scratch buffers ============//
+
+        std::vector<float> speedBuffer;      // current speed of the fan for each sample (Hz)
+        std::vector<float> fastBladesBuffer; // mono output of the fast blades
+        std::vector<float> mainBladesBuffer; // mono output of the main blades
     };
 }
\ No newline at end of file
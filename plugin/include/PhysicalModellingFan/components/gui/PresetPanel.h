@@ -5,7 +5,7 @@
 
 namespace jr
 {
-    class PresetPanel : public juce::Component, juce::Button::Listener, juce::ComboBox::Listener
+    class PresetPanel : public juce::Component, juce::Button::Listener, juce::ComboBox::Listener, juce::ChangeListener
     {
     public:
         PresetPanel(jr::PresetManager &pm) : presetManager(pm)
@@ -18,11 +18,15 @@ namespace jr
             addAndMakeVisible(presetList);
             presetList.addListener(this);
 
+            // the list is filled from the preset index, and refilled whenever the index changes on its background thread.
+            // The directory is rescanned now and polled for outside changes only while a panel is open
+            presetManager.getPresetIndex().addWatchingListener(this);
             loadPresetList();
         }
 
         ~PresetPanel()
         {
+            presetManager.getPresetIndex().removeWatchingListener(this);
             saveButton.removeListener(this);
             deleteButton.removeListener(this);
             presetList.removeListener(this);
@@ -66,16 +70,16 @@ namespace jr
             fileChooser->launchAsync(juce::FileBrowserComponent::saveMode, [&](const juce::FileChooser &chooser)
                                      {
                 const auto resultFile = chooser.getResult();
-                presetManager.savePreset(resultFile.getFileNameWithoutExtension()); 
-                loadPresetList(); });
+                presetManager.savePreset(resultFile.getFileNameWithoutExtension()); });
         }
 
         void onDeleteButtonClicked()
         {
             presetManager.deletePreset(presetManager.getCurrentPreset());
-            loadPresetList();
         }
 
+        void changeListenerCallback(juce::ChangeBroadcaster *) override { loadPresetList(); }
+
         void comboBoxChanged(juce::ComboBox *comboBox) override
         {
             if (comboBox == &presetList)
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <juce_gui_basics/juce_gui_basics.h>
+#include <PhysicalModellingFan/components/services/jr_CpuLoadMeter.h>
+#include <algorithm>
+#include <cmath>
+
+namespace jr
+{
+    /**
+     * A compact meter that shows the load of the audio processing against its real time deadline: the average load as a bar, the peak load as a line,
+     * the number of overruns and a histogram of the load of every block. The meter polls the CpuLoadMeter on a timer, and clicking it resets the statistics.
+     */
+    class CpuMeter : public juce::Component, juce::Timer
+    {
+    public:
+        CpuMeter(jr::CpuLoadMeter &m) : loadMeter(m)
+        {
+            startTimerHz(refreshRateHz);
+        }
+
+        ~CpuMeter() override { stopTimer(); }
+
+        void paint(juce::Graphics &g) override
+        {
+            const int margin = 4;
+            auto bounds = getLocalBounds().reduced(margin);
+            const auto textColour = getLookAndFeel().findColour(juce::Label::textColourId);
+
+            // top row: text, middle row: load bar with peak line, bottom row: histogram
+            auto textRow = bounds.removeFromTop(bounds.proportionOfHeight(0.4f));
+            auto barRow = bounds.removeFromTop(bounds.proportionOfHeight(0.4f)).reduced(0, 2);
+            auto histogramRow = bounds.reduced(0, 2);
+
+            g.setColour(textColour);
+            g.setFont(juce::FontOptions(juce::jmax(10.0f, textRow.getHeight() * 0.8f)));
+            g.drawText("CPU " + juce::String(juce::roundToInt(averageLoad * 100.0f)) + "%  peak " + juce::String(juce::roundToInt(peakLoad * 100.0f)) +
+                           "%  overruns " + juce::String(numOverruns),
+                       textRow, juce::Justification::centredLeft, true);
+
+            // loads are drawn up to 100%, anything over is an overrun
+            g.setColour(textColour.withAlpha(0.2f));
+            g.fillRect(barRow);
+            g.setColour(getLoadColour(averageLoad));
+            g.fillRect(barRow.withWidth(juce::roundToInt(barRow.getWidth() * juce::jlimit(0.0f, 1.0f, averageLoad))));
+            g.setColour(getLoadColour(peakLoad));
+            g.fillRect(barRow.getX() + juce::roundToInt((barRow.getWidth() - 2) * juce::jlimit(0.0f, 1.0f, peakLoad)), barRow.getY(), 2, barRow.getHeight());
+
+            // each bin is scaled against the fullest one, on a log scale so the rare slow blocks still show
+            const auto binWidth = histogramRow.getWidth() / static_cast<float>(CpuLoadMeter::numHistogramBins);
+            const auto maxCount = static_cast<float>(*std::max_element(histogram.begin(), histogram.end()));
+
+            for (int bin = 0; bin < CpuLoadMeter::numHistogramBins; bin++)
+            {
+                const auto count = static_cast<float>(histogram[static_cast<size_t>(bin)]);
+                if (count <= 0.0f)
+                    continue;
+
+                const auto height = histogramRow.getHeight() * std::log1p(count) / std::log1p(maxCount);
+                g.setColour(getLoadColour(bin / 10.0f));
+                g.fillRect(juce::Rectangle<float>(histogramRow.getX() + bin * binWidth, histogramRow.getBottom() - height, binWidth - 1.0f, height));
+            }
+        }
+
+        void mouseDown(const juce::MouseEvent &) override { loadMeter.reset(); }
+
+    private:
+        void timerCallback() override
+        {
+            averageLoad = loadMeter.getAverageLoad();
+            peakLoad = loadMeter.getPeakLoad();
+            numOverruns = loadMeter.getNumOverruns();
+
+            for (int bin = 0; bin < CpuLoadMeter::numHistogramBins; bin++)
+                histogram[static_cast<size_t>(bin)] = loadMeter.getHistogramCount(bin);
+
+            repaint();
+        }
+
+        /** Returns green for light loads, through orange to red at the deadline */
+        static juce::Colour getLoadColour(float load)
+        {
+            if (load >= 1.0f)
+                return juce::Colours::red;
+
+            return juce::Colours::limegreen.interpolatedWith(juce::Colours::orange, juce::jlimit(0.0f, 1.0f, (load - 0.5f) * 2.0f));
+        }
+
+        static constexpr int refreshRateHz{10};
+
+        jr::CpuLoadMeter &loadMeter;
+
+        // copies of the statistics made on each timer callback, so one paint shows a consistent set
+        float averageLoad{};
+        float peakLoad{};
+        uint32_t numOverruns{};
+        std::array<uint32_t, CpuLoadMeter::numHistogramBins> histogram{};
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CpuMeter)
+    };
+}
@@ -0,0 +1,140 @@
+/*
+  ==============================================================================
+
+    jr_CpuLoadMeter.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+
+namespace jr
+{
+    /**
+    Measures the load of each audio block, the time taken to process it as a fraction of the block's real time deadline (numSamples / sampleRate).
+    A load over 1 is an overrun, where the block took longer than it lasts, which causes a dropout when it happens on the host's audio thread.
+    Only the audio thread writes the statistics and every value is published with an atomic, so any thread can read them at any time without locking
+    */
+    class CpuLoadMeter
+    {
+    public:
+        static constexpr int numHistogramBins{11}; // ten 10% bins up to the deadline, then one bin for every overrun
+
+        /** Measures the block processed while it is in scope, construct it at the start of processBlock() */
+        class ScopedMeasurement
+        {
+        public:
+            ScopedMeasurement(CpuLoadMeter &_meter, int _numSamples)
+                : meter(_meter), numSamples(_numSamples), startTicks(juce::Time::getHighResolutionTicks()) {}
+
+            ~ScopedMeasurement()
+            {
+                meter.addBlock(juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks), numSamples);
+            }
+
+        private:
+            CpuLoadMeter &meter;
+            int numSamples;
+            juce::int64 startTicks;
+
+            JUCE_DECLARE_NON_COPYABLE(ScopedMeasurement)
+        };
+
+        /** Sets the sample rate the deadlines are worked out from, call from prepareToPlay()
+         * @param sampleRate - sample rate (Hz)
+         */
+        void prepare(double sampleRate)
+        {
+            if (sampleRate > 0.0)
+                secondsPerSample = 1.0 / sampleRate;
+        }
+
+        /** Adds the measurement of one block, called by ScopedMeasurement on the audio thread
+         * @param elapsedSeconds - time taken to process the block (seconds)
+         * @param numSamples - number of samples in the block
+         */
+        void addBlock(double elapsedSeconds, int numSamples)
+        {
+            if (resetRequested.exchange(false, std::memory_order_acquire))
+                clear();
+
+            const double deadline = numSamples * secondsPerSample;
+            if (deadline <= 0.0)
+                return;
+
+            const auto load = static_cast<float>(elapsedSeconds / deadline);
+
+            // weighted by the block duration, so the average covers the same time whatever the block size
+            average += static_cast<float>(juce::jmin(1.0, deadline / averagingTimeInS)) * (load - average);
+            averageLoad.store(average, std::memory_order_relaxed);
+
+            if (load > peakLoad.load(std::memory_order_relaxed))
+                peakLoad.store(load, std::memory_order_relaxed);
+
+            const int bin = juce::jlimit(0, numHistogramBins - 1, static_cast<int>(load * 10.0f));
+            increment(histogram[static_cast<size_t>(bin)]);
+
+            if (load > 1.0f)
+                increment(numOverruns);
+
+            increment(numBlocks);
+        }
+
+        /** Clears every statistic. The audio thread does this at the start of its next block, so the statistics are only ever written by one thread */
+        void reset() { resetRequested.store(true, std::memory_order_release); }
+
+        //================================= accessors ===================================//
+
+        /** Returns the load averaged over the last half a second or so (1 = the whole deadline) */
+        float getAverageLoad() const { return averageLoad.load(std::memory_order_relaxed); }
+
+        /** Returns the highest load of a single block since the last reset */
+        float getPeakLoad() const { return peakLoad.load(std::memory_order_relaxed); }
+
+        /** Returns the number of blocks that took longer than their deadline since the last reset */
+        uint32_t getNumOverruns() const { return numOverruns.load(std::memory_order_relaxed); }
+
+        /** Returns the number of blocks measured since the last reset */
+        uint32_t getNumBlocks() const { return numBlocks.load(std::memory_order_relaxed); }
+
+        /** Returns the number of blocks in a histogram bin since the last reset
+         * @param bin - bin index, bin n counts loads from n * 10% to (n + 1) * 10%, and the last bin counts every overrun
+         */
+        uint32_t getHistogramCount(int bin) const
+        {
+            return juce::isPositiveAndBelow(bin, numHistogramBins) ? histogram[static_cast<size_t>(bin)].load(std::memory_order_relaxed) : 0;
+        }
+
+    private:
+        // only the audio thread writes the counters, so they do not need a read-modify-write
+        static void increment(std::atomic<uint32_t> &counter) { counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+
+        void clear()
+        {
+            average = 0.0f;
+            averageLoad.store(0.0f, std::memory_order_relaxed);
+            peakLoad.store(0.0f, std::memory_order_relaxed);
+            numOverruns.store(0, std::memory_order_relaxed);
+            numBlocks.store(0, std::memory_order_relaxed);
+
+            for (auto &count : histogram)
+                count.store(0, std::memory_order_relaxed);
+        }
+
+        static constexpr double averagingTimeInS{0.5}; // time constant of the average load
+
+        double secondsPerSample{1.0 / 44100.0};
+        float average{}; // average load, only used on the audio thread
+
+        std::atomic<float> averageLoad{};
+        std::atomic<float> peakLoad{};
+        std::atomic<uint32_t> numOverruns{};
+        std::atomic<uint32_t> numBlocks{};
+        std::array<std::atomic<uint32_t>, numHistogramBins> histogram{};
+        std::atomic<bool> resetRequested{};
+    };
+}
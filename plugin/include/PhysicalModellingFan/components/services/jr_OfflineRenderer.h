@@ -0,0 +1,82 @@
+/*
+  ==============================================================================
+
+    jr_OfflineRenderer.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <PhysicalModellingFan/components/audio/jr_Machine.h>
+#include <PhysicalModellingFan/utils/jr_WorkerPool.h>
+#include <juce_core/juce_core.h>
+#include <optional>
+#include <vector>
+
+namespace jr
+{
+    /** A parameter change in an automation script, at a time from the start of the render */
+    struct AutomationPoint
+    {
+        double timeInSeconds{};
+        MachineParameterId id{};
+        float value{};
+    };
+
+    /** Everything needed to render one file */
+    struct RenderJob
+    {
+        juce::File presetFile;     // preset saved by the PresetManager, the Machine defaults are used if this is not set
+        juce::File automationFile; // automation script, optional
+        juce::File outputFile;     // .wav or .flac
+        double sampleRate{48000.0};
+        double durationInS{10.0};
+        int blockSize{512};
+        int bitDepth{24};
+        int numFans{};                // renders a scene of this many fans with a FanBank instead of one Machine, 0 renders the Machine
+        std::optional<uint64_t> seed; // seed for the noise generators, random if not set
+    };
+
+    /**
+    Renders the Machine to audio files without a host or an editor, as fast as the CPU allows.
+    Presets are the XML files written by the PresetManager, read with MachineParameters::loadPreset(), and automation scripts are text files with one change per line:
+
+        # time (s)  parameter  value
+        0.0         POWER      1
+        4.0         SPEED      9.5
+
+    Parameters use the same IDs and plain values as the plugin, bool parameters are on at 0.5 or more.
+    A job with numFans set renders a scene of that many fans through a FanBank. The scene is driven by the same parameters, motor envelope and smoothing
+    as the Machine, and the fans are rendered across a WorkerPool when one is given
+    */
+    class OfflineRenderer
+    {
+    public:
+        /**
+        Reads an automation script, the points are sorted by time
+        * @param file - automation script
+        * @param points - filled with the parameter changes in the script
+        */
+        static juce::Result loadAutomation(const juce::File &file, std::vector<AutomationPoint> &points);
+
+        /**
+        Renders a job and writes it to its output file
+        * @param job - job to render
+        * @param pool - pool the fans of a job with numFans set are rendered across, nullptr to render them on the calling thread
+        */
+        static juce::Result render(const RenderJob &job, WorkerPool *pool = nullptr);
+
+        /**
+        Renders a list of jobs, spread over a number of threads. When there are fewer jobs than threads,
+        the threads left over are shared out as a WorkerPool for each job thread, to render the fans of jobs with numFans set
+        * @param jobs - jobs to render
+        * @param numThreads - number of threads to render on, at least 1
+        * @return the result of each job, in the same order as the jobs
+        */
+        static std::vector<juce::Result> renderAll(const std::vector<RenderJob> &jobs, int numThreads);
+
+    private:
+        static constexpr float outputGain{0.4f}; // same output trim as the plugin, so renders match the plugin level
+    };
+}
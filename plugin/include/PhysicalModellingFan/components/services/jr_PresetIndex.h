@@ -0,0 +1,111 @@
+/*
+  ==============================================================================
+
+    jr_PresetIndex.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <PhysicalModellingFan/components/audio/jr_Machine.h>
+#include <juce_events/juce_events.h>
+#include <map>
+#include <optional>
+#include <vector>
+
+namespace jr
+{
+    /** What the PresetIndex knows about one preset file */
+    struct PresetInfo
+    {
+        juce::String name; // file name without the extension
+        juce::File file;
+        juce::Time modificationTime;
+        MachineParameters parameters; // parameters read from the file, values missing from the file keep their defaults
+    };
+
+    /**
+    An in memory index of the presets in a directory, so the preset list can be shown without touching the file system on the message thread.
+    A background thread builds the index on first use. Files saved or deleted through fileChanged() and fileDeleted() are picked up straight away,
+    and while a listener added with addWatchingListener() is registered the directory is also rescanned every few seconds, only reading the files
+    whose modification time has changed. With no one watching, the directory is left alone until the next rescan() or watching listener.
+    A change message is sent whenever the index changes, and every other method is safe to call from any thread except the audio thread
+    */
+    class PresetIndex : public juce::ChangeBroadcaster, private juce::Thread
+    {
+    public:
+        /**
+         * @param _directory - directory holding the presets, created by the background thread if it does not exist
+         * @param _extension - extension of the preset files, without the dot
+         * @param _rescanIntervalMs - time between scans of the whole directory while it is watched, which catch changes made outside the plugin (ms)
+         */
+        PresetIndex(const juce::File &_directory, const juce::String &_extension, int _rescanIntervalMs = 5000);
+        ~PresetIndex() override;
+
+        /** Returns every preset found so far sorted by name, starting the background scan if it has not started yet */
+        std::vector<PresetInfo> getPresets();
+
+        /** Returns the names of every preset found so far sorted by name, starting the background scan if it has not started yet */
+        juce::StringArray getPresetNames();
+
+        /** Returns a preset by name, or nothing if it is not in the index (yet) */
+        std::optional<PresetInfo> getPreset(const juce::String &name);
+
+        /** Returns true once the first scan of the directory has finished */
+        bool isReady() const { return hasScanned.load(); }
+
+        /** Re-reads a preset that has been written, on the background thread
+         * @param file - preset file that has been created or changed
+         */
+        void fileChanged(const juce::File &file);
+
+        /** Removes a preset that has been deleted
+         * @param file - preset file that has been deleted
+         */
+        void fileDeleted(const juce::File &file);
+
+        /** Rescans the whole directory on the background thread now rather than waiting for the next scan */
+        void rescan();
+
+        /** Adds a change listener that watches the directory, rescanning it straight away and then every rescan interval until the listener is removed.
+         * Use for a view of the presets that is open, so the directory is not polled when nothing shows it
+         * @param listener - listener to tell about changes, remove it with removeWatchingListener()
+         */
+        void addWatchingListener(juce::ChangeListener *listener);
+
+        /** Removes a listener added with addWatchingListener(), the periodic rescans stop once the last one is removed
+         * @param listener - listener to remove
+         */
+        void removeWatchingListener(juce::ChangeListener *listener);
+
+    private:
+        void run() override;
+
+        /** Starts the background thread if it is not already running */
+        void start();
+
+        /** Lists the directory and reads every file that is new or has changed since the last scan, returns false if the thread was stopped part way */
+        bool scanDirectory();
+
+        /** Applies the changes passed to fileChanged() and fileDeleted(), returns true if the index has changed */
+        bool applyPendingChanges();
+
+        /** Reads one preset file, returns nothing if it cannot be read */
+        std::optional<PresetInfo> readPreset(const juce::File &file) const;
+
+        const juce::File directory;
+        const juce::String extension;
+        const int rescanIntervalMs;
+
+        juce::CriticalSection lock;                              // guards presets and pendingChanges
+        std::map<juce::String, PresetInfo> presets;              // keyed by name, written only by the background thread
+        std::vector<std::pair<juce::File, bool>> pendingChanges; // files to re-read (true) or remove (false)
+
+        std::atomic<bool> hasScanned{false};
+        std::atomic<bool> rescanRequested{true};
+        std::atomic<int> numWatchers{0}; // listeners added with addWatchingListener(), the directory is only polled while there are some
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PresetIndex)
+    };
+}
@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+
+    jr_PresetLoader.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <PhysicalModellingFan/components/audio/jr_Machine.h>
+#include <PhysicalModellingFan/utils/jr_TripleBuffer.h>
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <functional>
+#include <optional>
+
+namespace jr
+{
+    /**
+    Loads presets without stalling the message thread or tearing the state the audio thread sees.
+    A background thread reads and checks the preset file, and turns it into a MachineParameters snapshot that is handed to the audio thread through a
+    TripleBuffer, so every parameter changes together at the start of one block. The apvts is then updated on the message thread for the editor and the host.
+    replaceState() changes the parameters one at a time, so until it has finished the audio thread keeps using the snapshot in place of the host parameters
+    */
+    class PresetLoader : private juce::Thread, private juce::AsyncUpdater
+    {
+    public:
+        explicit PresetLoader(juce::AudioProcessorValueTreeState &_apvts);
+        ~PresetLoader() override;
+
+        /** Called on the message thread once a preset is in the apvts, with the name it was loaded with */
+        std::function<void(const juce::String &presetName)> onPresetLoaded;
+
+        /** Loads a preset file on the background thread, a load that has not started yet is replaced by a newer one. Call from the message thread
+         * @param file - preset file
+         * @param presetName - name passed to onPresetLoaded
+         */
+        void load(const juce::File &file, const juce::String &presetName);
+
+        /** Puts a loaded preset into the apvts now rather than waiting for the message thread to get to it, call from the message thread */
+        void applyLoadedPreset() { handleUpdateNowIfNeeded(); }
+
+        /** Returns the parameters of a loaded preset that is not in the apvts yet, call once at the start of each block from the audio thread
+         * @param params - set to the parameters of the preset while it is loading
+         * @param isNewPreset - set to true on the first block of a new preset
+         * @return true if params should be used in place of the host parameters
+         */
+        bool getPresetParameters(MachineParameters &params, bool &isNewPreset);
+
+    private:
+        struct Snapshot
+        {
+            MachineParameters parameters;
+            juce::uint32 generation{}; // counts up with each preset loaded
+        };
+
+        struct LoadedPreset
+        {
+            juce::ValueTree state;
+            juce::String presetName;
+            juce::uint32 generation{};
+        };
+
+        void run() override;
+        void handleAsyncUpdate() override;
+
+        /** Reads a preset file into a state for the apvts and the parameters it holds, parameters missing from the file are set to their defaults */
+        juce::Result readPreset(const juce::File &file, juce::ValueTree &state, MachineParameters &params) const;
+
+        juce::AudioProcessorValueTreeState &apvts;
+        const juce::Identifier stateType; // type of the apvts state, read once here as replaceState() can change apvts.state while the background thread reads a preset
+
+        juce::CriticalSection lock;                                 // guards request and loaded
+        std::optional<std::pair<juce::File, juce::String>> request; // next file to load, with its preset name
+        std::optional<LoadedPreset> loaded;                         // waiting to be put into the apvts on the message thread
+        juce::uint32 lastGeneration{};                              // only used by the background thread
+
+        TripleBuffer<Snapshot> snapshots;
+        std::atomic<juce::uint32> appliedGeneration{}; // generation of the preset last put into the apvts
+
+        Snapshot snapshotInFlight{};     // only used by the audio thread
+        bool hasSnapshotInFlight{false}; // only used by the audio thread
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PresetLoader)
+    };
+}
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <juce_audio_processors/juce_audio_processors.h>
+#include <PhysicalModellingFan/components/services/jr_PresetIndex.h>
+#include <PhysicalModellingFan/components/services/jr_PresetLoader.h>
 
 namespace jr
 {
@@ -11,22 +13,37 @@ namespace jr
         static const juce::String extension;
         static const juce::String presetNameProperty;
 
-        PresetManager(juce::AudioProcessorValueTreeState &_apvts);
+        PresetManager(juce::AudioProcessorValueTreeState &_apvts, PresetLoader &_presetLoader);
 
         void savePreset(const juce::String &presetName);
         void deletePreset(const juce::String &presetName);
+
+        /** Starts loading a preset on the loader's background thread, the current preset changes once it is in the apvts */
         void loadPreset(const juce::String &presetName);
-        juce::StringArray getAllPresets();
+
+        /** Returns the names of the presets in the index, which is built on a background thread so this may be empty until the first scan finishes */
+        juce::StringArray getAllPresets() { return presetIndex->getPresetNames(); }
+
+        /** Returns the index of the preset directory, which every instance shares. Watch it to be told when presets are added, changed or removed */
+        PresetIndex &getPresetIndex() { return *presetIndex; }
 
         juce::String getCurrentPreset() { return currentPreset.toString(); }
         int getCurrentPresetIndex();
 
     private:
+        /** The index of the default preset directory, shared so there is one background thread however many instances are loaded */
+        struct SharedPresetIndex : PresetIndex
+        {
+            SharedPresetIndex() : PresetIndex(defaultDirectory, extension) {}
+        };
+
         void valueTreeRedirected(juce::ValueTree &treeWhichHasBeenChanged) override;
 
         juce::File getPresetFile(const juce::String &presetName);
 
         juce::AudioProcessorValueTreeState &apvts;
+        PresetLoader &presetLoader;
         juce::Value currentPreset;
+        juce::SharedResourcePointer<SharedPresetIndex> presetIndex;
     };
 }
@@ -0,0 +1,66 @@
+/*
+  ==============================================================================
+
+    jr_StateCodec.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <span>
+#include <string_view>
+
+namespace jr
+{
+    /**
+    Reads and writes the plugin state as a compact binary blob, in place of the XML written by copyXmlToBinary().
+    All values are little endian:
+      - 4 bytes  magic "JRFS", which can never be mistaken for the magic number at the start of copyXmlToBinary() data
+      - uint16   format version
+      - uint16   number of parameters, then for each parameter: uint8 id length, the id in ASCII, float32 value
+      - uint16   preset name length, then the preset name in UTF-8
+    decode() reads this in a single pass straight out of the host's data, into fixed size storage with views onto the blob, so it never allocates
+    */
+    class StateCodec
+    {
+    public:
+        static constexpr juce::uint16 currentVersion{1}; // version written by encode()
+        static constexpr int maxParameters{64};          // most parameters a state can hold
+        static constexpr size_t maxIdLength{255};        // longest parameter id that fits in its length byte
+        static constexpr size_t maxPresetNameLength{65535};
+
+        struct Parameter
+        {
+            std::string_view id;
+            float value{};
+        };
+
+        struct State
+        {
+            std::array<Parameter, maxParameters> parameters{};
+            int numParameters{};
+            std::string_view presetName; // UTF-8, not null terminated
+        };
+
+        /** Writes a state, replacing anything already in the block
+         * @param dest - block the state is written into
+         * @param parameters - parameter ids and values, at most maxParameters ids of at most maxIdLength characters
+         * @param presetName - name of the current preset, UTF-8
+         */
+        static void encode(juce::MemoryBlock &dest, std::span<const Parameter> parameters, std::string_view presetName);
+
+        /** Returns true if the data starts like a binary state, so other formats can be tried when it does not */
+        static bool isBinaryState(const void *data, size_t sizeInBytes);
+
+        /** Reads a state written by encode(), the views in the result point into data so it has to outlive them
+         * @param data - the state
+         * @param sizeInBytes - size of the state
+         * @param state - set to the decoded state, only complete if the result is ok
+         * @return fails if the data is not a binary state, is damaged or was written by a newer version
+         */
+        static juce::Result decode(const void *data, size_t sizeInBytes, State &state);
+    };
+}
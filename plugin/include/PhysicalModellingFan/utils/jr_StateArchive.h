@@ -0,0 +1,120 @@
+/*
+  ==============================================================================
+
+    jr_StateArchive.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+namespace jr
+{
+    /**
+    Walks the runtime state of a DSP object as a flat run of plain values, to save it into or restore it from a block of memory owned by the caller.
+    Each object lists its members once in a serialiseState() function, and the same list is used to measure, save, check and restore the state,
+    so saving and restoring can not get out of step. Values are copied exactly as they are in memory and nothing is allocated,
+    so a restored object carries on bit for bit where the saved one left off
+    */
+    class StateArchive
+    {
+    public:
+        enum class Mode
+        {
+            measure, // only counts the bytes the state takes up
+            save,    // copies the values into the memory
+            verify,  // reads through the memory checking expect() values, without changing anything
+            restore  // copies the values out of the memory
+        };
+
+        /**
+         * @param _mode - what the archive does with each value
+         * @param _data - memory to save into or restore from, unused when measuring
+         * @param _size - size of the memory (bytes)
+         */
+        StateArchive(Mode _mode, void *_data = nullptr, size_t _size = 0) : mode(_mode), data(static_cast<unsigned char *>(_data)), size(_size) {}
+
+        /** Saves or restores a list of values, which must be trivially copyable */
+        template <typename... Values>
+        void operator()(Values &...values)
+        {
+            static_assert((std::is_trivially_copyable_v<Values> && ...), "only trivially copyable values can be copied into a state");
+            (process(&values, sizeof(Values)), ...);
+        }
+
+        /** Saves or restores a contiguous run of values
+         * @param values - first value
+         * @param count - number of values
+         */
+        template <typename T>
+        void array(T *values, size_t count)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "only trivially copyable values can be copied into a state");
+            process(values, count * sizeof(T));
+        }
+
+        /** Saves a value that the object restoring the state must already have, such as a sample rate or buffer size.
+         * It is compared rather than restored, and the archive fails if it does not match
+         * @param value - value the state is only valid for
+         */
+        template <typename T>
+        void expect(const T &value)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "only trivially copyable values can be copied into a state");
+
+            if (!ok)
+                return;
+
+            if (mode != Mode::measure && position + sizeof(T) > size)
+            {
+                ok = false;
+                return;
+            }
+
+            if (mode == Mode::save)
+                std::memcpy(data + position, &value, sizeof(T));
+            else if (mode != Mode::measure)
+                ok = std::memcmp(data + position, &value, sizeof(T)) == 0;
+
+            position += sizeof(T);
+        }
+
+        Mode getMode() const { return mode; }
+
+        /** Returns false once the memory has run out or an expect() value has not matched, the archive stops copying at that point */
+        bool isOk() const { return ok; }
+
+        /** Returns the number of bytes used so far */
+        size_t getPosition() const { return position; }
+
+    private:
+        void process(void *value, size_t numBytes)
+        {
+            if (!ok)
+                return;
+
+            if (mode != Mode::measure && position + numBytes > size)
+            {
+                ok = false;
+                return;
+            }
+
+            if (mode == Mode::save)
+                std::memcpy(data + position, value, numBytes);
+            else if (mode == Mode::restore)
+                std::memcpy(value, data + position, numBytes);
+
+            position += numBytes;
+        }
+
+        Mode mode;
+        unsigned char *data;
+        size_t size;
+        size_t position{}; // bytes used so far
+        bool ok{true};     // false once the memory has run out or an expect() value has not matched
+    };
+}
@@ -0,0 +1,103 @@
+/*
+  ==============================================================================
+
+    jr_Trace.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <memory>
+
+// 1 to record the trace markers below, 0 to compile them out completely
+#ifndef JR_ENABLE_TRACING
+#define JR_ENABLE_TRACING 0
+#endif
+
+namespace jr
+{
+    /**
+    Records timed events from any thread and writes them out in the Chrome trace event format, which can be opened in chrome://tracing or ui.perfetto.dev.
+    Each thread records into its own fixed size ring buffer with no locks, so the audio thread never waits on the message thread.
+    Once a ring is full the oldest events are overwritten and counted, so a trace written at the end of a long session holds its most recent events.
+    A thread takes one of the buffers set aside by reserveThreadBuffers() the first time it records, and only allocates one if none are left,
+    so call JR_TRACE_RESERVE_THREADS() before real time threads start recording.
+    Use the JR_TRACE_ macros rather than calling this directly, so the markers compile to nothing unless JR_ENABLE_TRACING is 1
+    */
+    class Trace
+    {
+    public:
+        static constexpr int eventsPerThread{1 << 16}; // size of each thread's ring, a power of two
+
+        /** Records the time spent in the enclosing scope as one event */
+        class Scope
+        {
+        public:
+            /** @param _name - name of the event, must be a string literal as only the pointer is stored */
+            explicit Scope(const char *_name) : name(_name), startTicks(juce::Time::getHighResolutionTicks()) {}
+            ~Scope() { record(name, startTicks, juce::Time::getHighResolutionTicks()); }
+
+        private:
+            const char *name;
+            juce::int64 startTicks;
+
+            JUCE_DECLARE_NON_COPYABLE(Scope)
+        };
+
+        /** Records an event on the calling thread, lock free and without allocating once the thread has a buffer
+         * @param name - name of the event, must be a string literal as only the pointer is stored
+         * @param startTicks - start of the event, from juce::Time::getHighResolutionTicks()
+         * @param endTicks - end of the event, from juce::Time::getHighResolutionTicks()
+         */
+        static void record(const char *name, juce::int64 startTicks, juce::int64 endTicks);
+
+        /** Names the calling thread in the trace, the name is shown in place of the thread number
+         * @param name - thread name, must be a string literal as only the pointer is stored
+         */
+        static void setThreadName(const char *name);
+
+        /** Allocates buffers up front so that threads which start recording later, such as the audio thread, take one without allocating.
+         * Buffers that have not been taken yet count towards the number, so calling this again with the same number allocates nothing
+         * @param numBuffers - number of unused buffers to have ready
+         */
+        static void reserveThreadBuffers(int numBuffers);
+
+        /** Returns the number of events recorded so far on every thread, including those that have since been overwritten */
+        static juce::int64 getNumEvents();
+
+        /** Returns the number of events overwritten because a thread's ring wrapped round onto them */
+        static juce::int64 getNumOverwrittenEvents();
+
+        /** Returns every event still held in the rings as a Chrome trace JSON document. Safe to call while other threads are still recording,
+         * events that finish after the call starts, or are overwritten while it runs, are left out
+         */
+        static juce::String toJson();
+
+        /** Writes toJson() to a file
+         * @param file - file to write, replaced if it already exists
+         * @return a failed result if the file could not be written
+         */
+        static juce::Result writeJson(const juce::File &file);
+    };
+}
+
+#if JR_ENABLE_TRACING
+#define JR_TRACE_JOIN_(a, b) a##b
+#define JR_TRACE_JOIN(a, b) JR_TRACE_JOIN_(a, b)
+
+/** Records the time spent in the rest of the enclosing scope, name must be a string literal */
+#define JR_TRACE_SCOPE(name) const jr::Trace::Scope JR_TRACE_JOIN(jrTraceScope_, __LINE__)(name)
+
+/** Names the calling thread in the trace, name must be a string literal */
+#define JR_TRACE_THREAD_NAME(name) jr::Trace::setThreadName(name)
+
+/** Sets aside buffers for threads that have not recorded yet, call off the audio thread */
+#define JR_TRACE_RESERVE_THREADS(numThreads) jr::Trace::reserveThreadBuffers(numThreads)
+#else
+#define JR_TRACE_SCOPE(name) ((void)0)
+#define JR_TRACE_THREAD_NAME(name) ((void)0)
+#define JR_TRACE_RESERVE_THREADS(numThreads) ((void)0)
+#endif
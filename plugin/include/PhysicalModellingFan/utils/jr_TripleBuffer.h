@@ -0,0 +1,58 @@
+/*
+  ==============================================================================
+
+    jr_TripleBuffer.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+
+namespace jr
+{
+    /**
+    Hands the latest value of a plain type from one thread to another without locks or allocation.
+    The writer and the reader each own one of three slots and swap theirs with the shared middle slot, so neither ever waits on the other.
+    Values written faster than they are read are overwritten, the reader only ever sees the most recent one
+    */
+    template <typename T>
+    class TripleBuffer
+    {
+    public:
+        /** Publishes a value, call from the writing thread only
+         * @param value - value to publish
+         */
+        void write(const T &value)
+        {
+            slots[static_cast<size_t>(writeIndex)] = value;
+            writeIndex = middle.exchange(writeIndex | newValueFlag, std::memory_order_acq_rel) & indexMask;
+        }
+
+        /** Takes the latest value if one has been written since the last read, call from the reading thread only
+         * @param value - set to the latest value, left alone if there is nothing new
+         * @return true if there was a new value
+         */
+        bool read(T &value)
+        {
+            if ((middle.load(std::memory_order_relaxed) & newValueFlag) == 0)
+                return false;
+
+            readIndex = middle.exchange(readIndex, std::memory_order_acq_rel) & indexMask;
+            value = slots[static_cast<size_t>(readIndex)];
+
+            return true;
+        }
+
+    private:
+        static constexpr int indexMask{3};
+        static constexpr int newValueFlag{4}; // set in middle when it holds a value the reader has not taken
+
+        std::array<T, 3> slots{};
+        std::atomic<int> middle{1}; // index of the shared slot, with newValueFlag
+        int writeIndex{0};          // only used by the writer
+        int readIndex{2};           // only used by the reader
+    };
+}
@@ -0,0 +1,103 @@
+/*
+  ==============================================================================
+
+    jr_WorkerPool.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace jr
+{
+    /**
+    A pool of threads, started up front, that share out the items of a parallel loop run from the audio thread.
+    parallelFor() deals the items out to a fixed size work stealing deque for each thread, the calling thread included, and each thread takes
+    items from its own deque and then steals from the others, so uneven items even out. Nothing is locked or allocated once the pool is built.
+    Idle threads spin for a short time and then sleep on a futex (std::atomic::wait), and the calling thread waits for the others the same way
+    */
+    class WorkerPool
+    {
+    public:
+        static constexpr int maxItemsPerThread{256}; // size of each thread's deque, a loop with more items than fit runs on the calling thread alone
+        static constexpr int spinCount{4000};        // times a waiting thread checks for work before it sleeps
+
+        /** Starts the worker threads
+         * @param numThreads - threads that run each loop, including the thread that calls parallelFor(), so numThreads - 1 are started
+         */
+        explicit WorkerPool(int numThreads);
+        ~WorkerPool();
+
+        /** Returns the number of threads that run each loop, including the calling thread */
+        int getNumThreads() const { return static_cast<int>(deques.size()); }
+
+        /**
+        Calls a function once for each item, spread across the threads of the pool, and returns when every call has finished.
+        Call from one thread at a time, usually the audio thread, the function must be safe to call for different items at the same time
+        * @param numItems - number of items
+        * @param function - called as function(item) for each item from 0 to numItems - 1
+        */
+        template <typename Function>
+        void parallelFor(int numItems, Function &&function)
+        {
+            using FunctionType = std::remove_reference_t<Function>;
+
+            runLoop(numItems, [](void *context, int item) { (*static_cast<FunctionType *>(context))(item); }, const_cast<void *>(static_cast<const void *>(&function)));
+        }
+
+    private:
+        using ItemFunction = void (*)(void *context, int item);
+
+        /**
+        A Chase-Lev deque that is filled before each loop starts, then the owner pops items from the bottom and other threads steal them from the top
+        */
+        struct alignas(64) Deque
+        {
+            std::array<int, maxItemsPerThread> items{};
+            std::atomic<int> top{0};
+            std::atomic<int> bottom{0};
+
+            /** Replaces the contents with the items first to first + count - 1, only while no other thread can use the deque */
+            void fill(int first, int count);
+
+            /** Takes the item at the bottom, call from the owning thread only */
+            bool pop(int &item);
+
+            /** Takes the item at the top, from any thread */
+            bool steal(int &item);
+        };
+
+        class Worker : public juce::Thread
+        {
+        public:
+            Worker(WorkerPool &_pool, int _threadIndex);
+            void run() override;
+
+        private:
+            WorkerPool &pool;
+            int threadIndex;
+        };
+
+        void runLoop(int numItems, ItemFunction function, void *context);
+
+        /** Runs items from the thread's own deque, then steals from the others, until there are none left to take */
+        void runItems(int threadIndex);
+
+        std::vector<std::unique_ptr<Deque>> deques; // one for each thread, index 0 belongs to the thread calling parallelFor()
+        std::vector<std::unique_ptr<Worker>> workers;
+
+        ItemFunction jobFunction{};        // function of the current loop, only written while no worker is running items
+        void *jobContext{};                // context passed to jobFunction
+        std::atomic<bool> jobOpen{};       // true while workers may take items from the deques
+        std::atomic<int> numActive{};      // workers that have woken up for a loop and not finished with it
+        std::atomic<juce::uint32> epoch{}; // incremented to wake the workers for each loop, and when the pool is destroyed
+        bool isRunning{false};             // true while parallelFor() is running, to catch calls from more than one thread
+    };
+}
@@ -0,0 +1,111 @@
+/*
+  ==============================================================================
+
+    jr_simdUtils.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <algorithm>
+
+namespace jr
+{
+    /**
+    Helpers for running juce::dsp::SIMDRegister kernels over buffers that may not be SIMD aligned.
+    Unaligned and partial registers go through an aligned temporary, so every sample sees exactly the same maths regardless of where the buffer sits in memory
+    */
+    class SimdUtils
+    {
+    public:
+        using FloatVec = juce::dsp::SIMDRegister<float>;
+
+        static constexpr int width = static_cast<int>(FloatVec::SIMDNumElements); // number of floats per SIMD register
+
+        /**
+        loads up to one register of floats, lanes past numValues are filled with padValue
+        */
+        static FloatVec load(const float *source, int numValues = width, float padValue = 0.0f)
+        {
+            if (numValues == width && FloatVec::isSIMDAligned(source))
+                return FloatVec::fromRawArray(source);
+
+            alignas(FloatVec::SIMDRegisterSize) float lanes[width];
+            for (int i = 0; i < width; i++)
+                lanes[i] = i < numValues ? source[i] : padValue;
+
+            return FloatVec::fromRawArray(lanes);
+        }
+
+        /**
+        stores the first numValues lanes of a register
+        */
+        static void store(FloatVec value, float *dest, int numValues = width)
+        {
+            if (numValues == width && FloatVec::isSIMDAligned(dest))
+            {
+                value.copyToRawArray(dest);
+                return;
+            }
+
+            alignas(FloatVec::SIMDRegisterSize) float lanes[width];
+            value.copyToRawArray(lanes);
+            std::copy(lanes, lanes + numValues, dest);
+        }
+
+        /**
+         * sin(2 * pi * t) of each lane, for a phase t in the range 0-1.
+         * The phase is folded into a quarter wave and evaluated with a degree 9 odd Taylor polynomial,
+         * the truncation error is at most (pi/2)^11 / 11! = 3.6e-6 (-109 dB), plus float rounding of around 1e-7
+         */
+        static FloatVec sin2Pi(FloatVec t)
+        {
+            // sin(2pi t) = -sin(2pi u) with u = t - 0.5 in [-0.5, 0.5), then fold u into [-0.25, 0.25] using sin(pi - x) = sin(x)
+            auto u = t - 0.5f;
+            auto v = FloatVec::max(FloatVec::min(u, FloatVec::expand(0.5f) - u), FloatVec::expand(-0.5f) - u);
+
+            // coefficients of sin(2pi v) as a polynomial in v: (-1)^n (2pi)^(2n+1) / (2n+1)!
+            auto v2 = v * v;
+            auto poly = FloatVec::expand(42.058693944897634f);
+            poly = FloatVec::multiplyAdd(FloatVec::expand(-76.70585975306136f), poly, v2);
+            poly = FloatVec::multiplyAdd(FloatVec::expand(81.60524927607504f), poly, v2);
+            poly = FloatVec::multiplyAdd(FloatVec::expand(-41.341702240399755f), poly, v2);
+            poly = FloatVec::multiplyAdd(FloatVec::expand(6.283185307179586f), poly, v2);
+
+            return FloatVec::expand(0.0f) - (poly * v);
+        }
+
+        /**
+        exact reciprocal of each lane
+        */
+        static FloatVec exactReciprocal(FloatVec x)
+        {
+            alignas(FloatVec::SIMDRegisterSize) float lanes[width];
+            x.copyToRawArray(lanes);
+
+            for (auto &lane : lanes)
+                lane = 1.0f / lane;
+
+            return FloatVec::fromRawArray(lanes);
+        }
+
+        /**
+        hardware reciprocal estimate of each lane, refined with one Newton-Raphson step.
+        The relative error is below 2.5e-7 on x86 (12 bit estimate) and around 1.5e-5 on ARM NEON (8 bit estimate)
+        */
+        static FloatVec fastReciprocal(FloatVec x)
+        {
+#if JUCE_USE_SIMD && (defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86))
+            auto estimate = FloatVec::fromNative(_mm_rcp_ps(x.value));
+#elif JUCE_USE_SIMD && (defined(__ARM_NEON__) || defined(__ARM_NEON) || defined(_M_ARM64))
+            auto estimate = FloatVec::fromNative(vrecpeq_f32(x.value));
+#else
+            auto estimate = exactReciprocal(x);
+#endif
+            // e' = e * (2 - x * e) roughly doubles the number of correct bits
+            return estimate * (FloatVec::expand(2.0f) - x * estimate);
+        }
+    };
+}
@@ -5,7 +5,7 @@
 
 //==============================================================================
 AudioPluginAudioProcessorEditor::AudioPluginAudioProcessorEditor(AudioPluginAudioProcessor &p)
-    : AudioProcessorEditor(&p), processorRef(p), presetPanel(p.getPresetManager()), fanControls(p), sharedControls(p)
+    : AudioProcessorEditor(&p), processorRef(p), presetPanel(p.getPresetManager()), cpuMeter(p.getCpuLoadMeter()), fanControls(p), sharedControls(p)
 {
     juce::LookAndFeel::setDefaultLookAndFeel(&myLookAndFeel);
     setLookAndFeel(&myLookAndFeel);
@@ -14,6 +14,7 @@ AudioPluginAudioProcessorEditor::AudioPluginAudioProcessorEditor(AudioPluginAudi
     sharedControls.init();
 
     addAndMakeVisible(presetPanel);
+    addAndMakeVisible(cpuMeter);
     addAndMakeVisible(fanControls);
     addAndMakeVisible(sharedControls);
 
@@ -38,8 +39,9 @@ void AudioPluginAudioProcessorEditor::paint(juce::Graphics &g)
 void AudioPluginAudioProcessorEditor::resized()
 {
 
-    // top presets row
-    presetPanel.setBoundsRelative(0.0f, 0.0f, 1.0f, 0.1f);
+    // top presets row, with the cpu meter on the right
+    presetPanel.setBoundsRelative(0.0f, 0.0f, 0.8f, 0.1f);
+    cpuMeter.setBoundsRelative(0.8f, 0.0f, 0.2f, 0.1f);
 
     fanControls.setBoundsRelative(0.0f, 0.1f, 0.5f, 0.9f);
     sharedControls.setBoundsRelative(0.5f, 0.1f, 0.5f, 0.9f);
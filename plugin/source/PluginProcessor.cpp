@@ -1,5 +1,7 @@
 #include "PhysicalModellingFan/PluginProcessor.h"
 #include "PhysicalModellingFan/PluginEditor.h"
+#include <PhysicalModellingFan/components/services/jr_StateCodec.h>
+#include <PhysicalModellingFan/utils/jr_Trace.h>
 
 //==============================================================================
 AudioPluginAudioProcessor::AudioPluginAudioProcessor()
@@ -15,30 +17,31 @@ AudioPluginAudioProcessor::AudioPluginAudioProcessor()
 {
     apvts.state.setProperty(jr::PresetManager::presetNameProperty, "", nullptr);
 
-    apvts.addParameterListener(ID::GAIN, &masterGainListener);
-    apvts.addParameterListener(ID::SPEED, &speedListener);
-    apvts.addParameterListener(ID::FAN_TONE, &fanToneLevelListener);
-    apvts.addParameterListener(ID::FAN_NOISE, &fanNoiseLevelListener);
-    apvts.addParameterListener(ID::FAN_WIDTH, &fanStereoWidthListener);
-    apvts.addParameterListener(ID::FAN_DOPPLER, &fanDopplerToggleListener);
-    apvts.addParameterListener(ID::POWER, &powerToggleListener);
-    apvts.addParameterListener(ID::POWER_UP_T, &powerUpTimeListener);
-    apvts.addParameterListener(ID::POWER_DOWN_T, &powerDownTimeListener);
-
-    presetManager = std::make_unique<jr::PresetManager>(apvts);
+    gainParam = apvts.getRawParameterValue(ID::GAIN);
+    speedParam = apvts.getRawParameterValue(ID::SPEED);
+    fanToneParam = apvts.getRawParameterValue(ID::FAN_TONE);
+    fanNoiseParam = apvts.getRawParameterValue(ID::FAN_NOISE);
+    fanWidthParam = apvts.getRawParameterValue(ID::FAN_WIDTH);
+    fanDopplerParam = apvts.getRawParameterValue(ID::FAN_DOPPLER);
+    powerParam = apvts.getRawParameterValue(ID::POWER);
+    powerUpTimeParam = apvts.getRawParameterValue(ID::POWER_UP_T);
+    powerDownTimeParam = apvts.getRawParameterValue(ID::POWER_DOWN_T);
+    instrumentModeParam = apvts.getRawParameterValue(ID::INSTRUMENT_MODE);
+
+    presetManager = std::make_unique<jr::PresetManager>(apvts, presetLoader);
 }
 
 AudioPluginAudioProcessor::~AudioPluginAudioProcessor()
 {
-    apvts.removeParameterListener(ID::GAIN, &masterGainListener);
-    apvts.removeParameterListener(ID::SPEED, &speedListener);
-    apvts.removeParameterListener(ID::FAN_TONE, &fanToneLevelListener);
-    apvts.removeParameterListener(ID::FAN_NOISE, &fanNoiseLevelListener);
-    apvts.removeParameterListener(ID::FAN_WIDTH, &fanStereoWidthListener);
-    apvts.removeParameterListener(ID::FAN_DOPPLER, &fanDopplerToggleListener);
-    apvts.removeParameterListener(ID::POWER, &powerToggleListener);
-    apvts.removeParameterListener(ID::POWER_UP_T, &powerUpTimeListener);
-    apvts.removeParameterListener(ID::POWER_DOWN_T, &powerDownTimeListener);
+#if JR_ENABLE_TRACING
+    // the standalone app has no other place to save the trace, so it is written out when the app closes
+    if (wrapperType == wrapperType_Standalone)
+    {
+        const auto traceFile = juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile("PhysicalModellingFan-trace.json");
+        const auto result = jr::Trace::writeJson(traceFile);
+        DBG((result.wasOk() ? "Trace written to: " + traceFile.getFullPathName() : result.getErrorMessage()));
+    }
+#endif
 }
 
 //==============================================================================
@@ -109,12 +112,23 @@ void AudioPluginAudioProcessor::changeProgramName(int index, const juce::String
 //==============================================================================
 void AudioPluginAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
-    juce::ignoreUnused(samplesPerBlock);
-
-    machine.setSampleRate((float)sampleRate);
-    machine.setSpeed(*apvts.getRawParameterValue(ID::SPEED));
-    machine.setFanDoppler(*apvts.getRawParameterValue(ID::FAN_DOPPLER));
-    machine.setGain(*apvts.getRawParameterValue(ID::GAIN));
+    // the trace buffer of the audio thread is set aside here, so its first traced block does not allocate. Some hosts move processing between two threads
+    JR_TRACE_RESERVE_THREADS(2);
+
+    machine.prepare((float)sampleRate, samplesPerBlock);
+    cpuLoadMeter.prepare(sampleRate);
+    machine.setParameters(readParameters());
+
+    // every voice is allocated here, so notes never allocate on the audio thread
+    synth.prepare((float)sampleRate, samplesPerBlock, numSynthVoices);
+    synth.setParameters(readParameters());
+
+    // the fade machine is copied from the machine, so it is prepared the same way to have its buffers allocated here rather than on the audio thread
+    fadeMachine.prepare((float)sampleRate, samplesPerBlock);
+    fadeLengthInSamples = static_cast<int>(presetCrossfadeTimeInS * sampleRate);
+    fadeSamplesRemaining = 0;
+    fadeLeft.assign(static_cast<size_t>(juce::jmax(1, samplesPerBlock)), 0.0f);
+    fadeRight.assign(static_cast<size_t>(juce::jmax(1, samplesPerBlock)), 0.0f);
 }
 
 void AudioPluginAudioProcessor::releaseResources()
@@ -149,8 +163,9 @@ bool AudioPluginAudioProcessor::isBusesLayoutSupported(const BusesLayout &layout
 void AudioPluginAudioProcessor::processBlock(juce::AudioBuffer<float> &buffer,
                                              juce::MidiBuffer &midiMessages)
 {
-    juce::ignoreUnused(midiMessages);
-
+    JR_TRACE_THREAD_NAME("Audio");
+    JR_TRACE_SCOPE("processBlock");
+    const jr::CpuLoadMeter::ScopedMeasurement loadMeasurement(cpuLoadMeter, buffer.getNumSamples());
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
@@ -170,13 +185,131 @@ void AudioPluginAudioProcessor::processBlock(juce::AudioBuffer<float> &buffer,
 
     float gainVal = 0.4f;
 
-    //=============================== DSP LOOP ===============================//
-    for (int i = 0; i < numSamples; i++)
+    //=============================== DSP BLOCK ===============================//
+    // parameters are only read here on the audio thread, so the DSP state is never written from another thread.
+    // A preset that is still being put into the apvts is used whole, so it never sounds with only some of its parameters set
+    bool isNewPreset = false;
+    const bool isPresetLoading = presetLoader.getPresetParameters(presetParameters, isNewPreset);
+    const bool isInstrumentMode = instrumentModeParam->load(std::memory_order_relaxed) >= 0.5f;
+
+    if (isNewPreset && fadeLengthInSamples > 0 && !isInstrumentMode)
+    {
+        JR_TRACE_SCOPE("copyMachine");
+        fadeMachine = machine; // the buffers are the same size, so this copies without allocating
+        fadeSamplesRemaining = fadeLengthInSamples;
+    }
+
+    const auto params = isPresetLoading ? presetParameters : readParameters();
+    machine.setParameters(params);
+    synth.setParameters(params);
+
+    if (auto *playHead = getPlayHead())
+        if (auto position = playHead->getPosition())
+            if (auto timeInSamples = position->getTimeInSamples())
+                timelinePosition = *timeInSamples;
+
+    // scheduled changes split the block so they land on the right sample
+    int numEvents = eventQueue.popEventsForBlock(timelinePosition, numSamples, blockEvents.data(), static_cast<int>(blockEvents.size()));
+    bool isSilent = false;
+
+    if (isInstrumentMode)
+    {
+        // the notes power the synth voices in place of the machine, which holds still until instrument mode is turned off.
+        // It still takes the scheduled changes, so it carries on from them rather than losing them
+        for (int i = 0; i < numEvents; i++)
+            machine.setParameter(blockEvents[static_cast<size_t>(i)].id, blockEvents[static_cast<size_t>(i)].value);
+
+        isSilent = synth.isIdle() && midiMessages.isEmpty();
+        renderInstrument(leftChannel, rightChannel, numSamples, midiMessages);
+    }
+    else
+    {
+        // notes held when instrument mode was turned off would be stuck on when it is turned back on
+        synth.allNotesOff();
+
+        isSilent = numEvents == 0 && machine.isIdle() && fadeSamplesRemaining == 0;
+        machine.processBlock(leftChannel, rightChannel, numSamples, blockEvents.data(), numEvents);
+
+        if (fadeSamplesRemaining > 0)
+            renderPresetCrossfade(leftChannel, rightChannel, numSamples);
+    }
+
+    timelinePosition += numSamples;
+
+    if (isSilent)
+    {
+        // clearing the whole buffer marks it as silent, which lets the host skip processing downstream where the format supports it
+        buffer.clear();
+        return;
+    }
+
+    juce::FloatVectorOperations::multiply(leftChannel, gainVal, numSamples);
+    juce::FloatVectorOperations::multiply(rightChannel, gainVal, numSamples);
+}
+
+jr::MachineParameters AudioPluginAudioProcessor::readParameters() const
+{
+    jr::MachineParameters params;
+
+    params.gain = gainParam->load(std::memory_order_relaxed);
+    params.speed = speedParam->load(std::memory_order_relaxed);
+    params.toneLevel = fanToneParam->load(std::memory_order_relaxed);
+    params.noiseLevel = fanNoiseParam->load(std::memory_order_relaxed);
+    params.stereoWidth = fanWidthParam->load(std::memory_order_relaxed);
+    params.dopplerOn = fanDopplerParam->load(std::memory_order_relaxed) >= 0.5f;
+    params.powerOn = powerParam->load(std::memory_order_relaxed) >= 0.5f;
+    params.powerUpTime = powerUpTimeParam->load(std::memory_order_relaxed);
+    params.powerDownTime = powerDownTimeParam->load(std::memory_order_relaxed);
+
+    return params;
+}
+
+void AudioPluginAudioProcessor::renderInstrument(float *left, float *right, int numSamples, const juce::MidiBuffer &midiMessages)
+{
+    JR_TRACE_SCOPE("renderInstrument");
+
+    int position = 0;
+
+    // the block is split at each message, so every note starts and stops on its own sample
+    for (const auto metadata : midiMessages)
+    {
+        const int messagePosition = juce::jlimit(position, numSamples, metadata.samplePosition);
+        synth.processBlock(left + position, right + position, messagePosition - position);
+        position = messagePosition;
+
+        const auto message = metadata.getMessage();
+
+        if (message.isNoteOn())
+            synth.noteOn(message.getNoteNumber(), message.getFloatVelocity());
+        else if (message.isNoteOff())
+            synth.noteOff(message.getNoteNumber());
+        else if (message.isAllNotesOff() || message.isAllSoundOff())
+            synth.allNotesOff();
+    }
+
+    synth.processBlock(left + position, right + position, numSamples - position);
+}
+
+void AudioPluginAudioProcessor::renderPresetCrossfade(float *left, float *right, int numSamples)
+{
+    JR_TRACE_SCOPE("renderPresetCrossfade");
+
+    const float gainStep = 1.0f / static_cast<float>(fadeLengthInSamples);
+    const int chunkSize = static_cast<int>(fadeLeft.size());
+
+    for (int start = 0; start < numSamples && fadeSamplesRemaining > 0; start += chunkSize)
     {
-        machine.process();
+        const int numToFade = juce::jmin(chunkSize, numSamples - start, fadeSamplesRemaining);
+        fadeMachine.processBlock(fadeLeft.data(), fadeRight.data(), numToFade);
+
+        for (int i = 0; i < numToFade; i++)
+        {
+            const float oldGain = static_cast<float>(--fadeSamplesRemaining) * gainStep;
+            const float newGain = 1.0f - oldGain;
 
-        leftChannel[i] = gainVal * machine.getCurrentSampleLeft();
-        rightChannel[i] = gainVal * machine.getCurrentSampleRight();
+            left[start + i] = (left[start + i] * newGain) + (fadeLeft[static_cast<size_t>(i)] * oldGain);
+            right[start + i] = (right[start + i] * newGain) + (fadeRight[static_cast<size_t>(i)] * oldGain);
+        }
     }
 }
 
@@ -194,23 +327,71 @@ juce::AudioProcessorEditor *AudioPluginAudioProcessor::createEditor()
 //==============================================================================
 void AudioPluginAudioProcessor::getStateInformation(juce::MemoryBlock &destData)
 {
-    auto state = apvts.copyState();
-    std::unique_ptr<juce::XmlElement> xml(state.createXml());
-    copyXmlToBinary(*xml, destData);
+    JR_TRACE_SCOPE("getStateInformation");
+
+    // the binary state is written straight from the parameters, rather than copying the apvts state and turning it into XML
+    std::array<jr::StateCodec::Parameter, jr::StateCodec::maxParameters> parameters{};
+    size_t numParameters = 0;
+
+    for (auto *parameter : getParameters())
+        if (const auto *ranged = dynamic_cast<juce::RangedAudioParameter *>(parameter); ranged != nullptr && numParameters < parameters.size())
+            parameters[numParameters++] = {ranged->paramID.toRawUTF8(), ranged->convertFrom0to1(ranged->getValue())};
+
+    const auto presetName = presetManager->getCurrentPreset();
+    jr::StateCodec::encode(destData, std::span(parameters.data(), numParameters), presetName.toRawUTF8());
 }
 
 void AudioPluginAudioProcessor::setStateInformation(const void *data, int sizeInBytes)
 {
+    if (jr::StateCodec::isBinaryState(data, static_cast<size_t>(juce::jmax(0, sizeInBytes))))
+    {
+        setBinaryState(data, static_cast<size_t>(sizeInBytes));
+        return;
+    }
+
+    // sessions saved before the binary state was added hold the apvts state as XML
     std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
     if (xmlState.get() != nullptr)
     {
         if (xmlState->hasTagName(apvts.state.getType()))
         {
+            JR_TRACE_SCOPE("replaceState");
             apvts.replaceState(juce::ValueTree::fromXml(*xmlState));
         }
     }
 }
 
+void AudioPluginAudioProcessor::setBinaryState(const void *data, size_t sizeInBytes)
+{
+    JR_TRACE_SCOPE("setBinaryState");
+
+    jr::StateCodec::State state;
+    if (const auto result = jr::StateCodec::decode(data, sizeInBytes, state); result.failed())
+    {
+        DBG(result.getErrorMessage());
+        jassertfalse;
+        return;
+    }
+
+    const auto decoded = std::span(state.parameters.data(), static_cast<size_t>(state.numParameters));
+
+    // parameters missing from the state go back to their defaults, as they do when an XML state is loaded with replaceState()
+    for (auto *parameter : getParameters())
+    {
+        if (auto *ranged = dynamic_cast<juce::RangedAudioParameter *>(parameter))
+        {
+            const std::string_view id{ranged->paramID.toRawUTF8()};
+            const auto found = std::find_if(decoded.begin(), decoded.end(), [&](const auto &p)
+                                            { return p.id == id; });
+
+            ranged->setValueNotifyingHost(found != decoded.end() ? ranged->convertTo0to1(found->value) : ranged->getDefaultValue());
+        }
+    }
+
+    apvts.state.setProperty(jr::PresetManager::presetNameProperty,
+                            juce::String::fromUTF8(state.presetName.data(), static_cast<int>(state.presetName.size())), nullptr);
+}
+
 //==============================================================================
 // This creates new instances of the plugin..
 juce::AudioProcessor *JUCE_CALLTYPE createPluginFilter()
@@ -234,6 +415,7 @@ juce::AudioProcessorValueTreeState::ParameterLayout AudioPluginAudioProcessor::c
     layout.add(std::make_unique<juce::AudioParameterFloat>(ID::POWER_UP_T, "Power Up Time (s)", 0.1f, 8.0f, 1.5f));
     layout.add(std::make_unique<juce::AudioParameterFloat>(ID::POWER_DOWN_T, "Power Down Time (s)", 0.1f, 8.0f, 1.5f));
     layout.add(std::make_unique<juce::AudioParameterFloat>(ID::ACCEL_RATE, "Acceleration Rate", 0.0f, 1.0f, 0.5f));
+    layout.add(std::make_unique<juce::AudioParameterBool>(ID::INSTRUMENT_MODE, "Instrument Mode", false));
 
     return layout;
 }
\ No newline at end of file
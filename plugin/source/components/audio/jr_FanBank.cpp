@@ -0,0 +1,357 @@
+#include <PhysicalModellingFan/components/audio/jr_FanBank.h>
+#include <PhysicalModellingFan/utils/jr_Trace.h>
+
+namespace jr
+{
+    namespace
+    {
+        constexpr int width{SimdUtils::width};
+
+        size_t getNumGroups(int numVoices) { return static_cast<size_t>((numVoices + width - 1) / width); }
+
+        /** one pole smoothing coefficient that covers about 99% of a change in the given time */
+        float smoothingCoefficient(float timeInS, float sampleRate) { return 1.0f - std::exp(-4.6f / (timeInS * sampleRate)); }
+    }
+
+    void FanBank::prepare(float _sampleRate, int _maxBlockSize, int _maxVoices)
+    {
+        sampleRate = _sampleRate;
+        maxBlockSize = juce::jmax(1, _maxBlockSize);
+        maxVoices = juce::jmax(0, _maxVoices);
+
+        const auto numGroups = getNumGroups(maxVoices);
+        const auto zero = FloatVec::expand(0.0f);
+
+        for (auto *values : {&targetSpeed, &targetGain, &toneLevel, &noiseLevel, &panWidth, &dopplerOn, &damping, &speed, &gain, &phase,
+                             &mainCoefficient, &mainCoefficientStep, &mainState1, &mainState2, &fastState1, &fastState2})
+            values->assign(numGroups, zero);
+
+        noise.resize(numGroups);
+
+        // room for the longest fast blades delay, plus the sample after it for interpolation
+        const auto maxDelayInSamples = static_cast<int>(std::ceil((delayTimeInMs + chopInMs) * sampleRate / 1000.0f)) + 2;
+        delaySize = juce::nextPowerOfTwo(maxDelayInSamples);
+        delayBuffer.assign(numGroups * static_cast<size_t>(delaySize), zero);
+
+        groupMixLeft.assign(numGroups * static_cast<size_t>(maxBlockSize), zero);
+        groupMixRight.assign(numGroups * static_cast<size_t>(maxBlockSize), zero);
+
+        speedSmoothing = smoothingCoefficient(speedSmoothingInS, sampleRate);
+        gainSmoothing = smoothingCoefficient(gainSmoothingInS, sampleRate);
+        fixedCoefficient = cutoffToCoefficient(FloatVec::expand(fixedCutoff)).get(0);
+
+        numVoices = juce::jmin(numVoices, maxVoices);
+
+        for (int voice = 0; voice < maxVoices; voice++)
+            setVoiceParameters(voice, {});
+
+        reset();
+    }
+
+    void FanBank::setNumVoices(int _numVoices)
+    {
+        const int newNumVoices = juce::jlimit(0, maxVoices, _numVoices);
+
+        // voices that start being rendered fade in from silence
+        for (int voice = numVoices; voice < newNumVoices; voice++)
+            gain[static_cast<size_t>(voice / width)].set(static_cast<size_t>(voice % width), 0.0f);
+
+        numVoices = newNumVoices;
+    }
+
+    void FanBank::setVoiceParameters(int voice, const VoiceParameters &params)
+    {
+        jassert(juce::isPositiveAndBelow(voice, maxVoices));
+        if (!juce::isPositiveAndBelow(voice, maxVoices))
+            return;
+
+        const auto group = static_cast<size_t>(voice / width);
+        const auto lane = static_cast<size_t>(voice % width);
+
+        targetSpeed[group].set(lane, juce::jmax(0.0f, params.speed));
+        targetGain[group].set(lane, juce::jlimit(0.0f, 1.0f, params.gain));
+        toneLevel[group].set(lane, juce::jlimit(0.0f, 1.0f, params.toneLevel));
+        noiseLevel[group].set(lane, juce::jlimit(0.0f, 1.0f, params.noiseLevel));
+        panWidth[group].set(lane, juce::jlimit(0.0f, 1.0f, params.stereoWidth));
+        dopplerOn[group].set(lane, params.dopplerOn ? 1.0f : 0.0f);
+        damping[group].set(lane, 1.0f / (params.dopplerOn ? dopplerResonance : fixedResonance));
+    }
+
+    void FanBank::setSeed(uint64_t seed)
+    {
+        for (size_t group = 0; group < noise.size(); group++)
+            noise[group].setSeed(seed + group);
+    }
+
+    void FanBank::setControlInterval(int numSamples)
+    {
+        if (numSamples > 0)
+        {
+            controlInterval = numSamples;
+            samplesUntilControlUpdate = juce::jmin(samplesUntilControlUpdate, controlInterval);
+        }
+    }
+
+    void FanBank::setWorkerPool(WorkerPool *pool, int minBlockSize)
+    {
+        workerPool = pool;
+        minParallelBlockSize = juce::jmax(1, minBlockSize);
+    }
+
+    void FanBank::reset()
+    {
+        const auto zero = FloatVec::expand(0.0f);
+
+        for (auto *values : {&mainCoefficientStep, &mainState1, &mainState2, &fastState1, &fastState2})
+            std::fill(values->begin(), values->end(), zero);
+
+        std::fill(mainCoefficient.begin(), mainCoefficient.end(), FloatVec::expand(fixedCoefficient));
+        std::fill(delayBuffer.begin(), delayBuffer.end(), zero);
+
+        // the blades of each fan start at a different angle, spread out by the golden ratio so they never line up
+        for (int voice = 0; voice < maxVoices; voice++)
+        {
+            const float startPhase = static_cast<float>(voice) * 0.6180339887f;
+            phase[static_cast<size_t>(voice / width)].set(static_cast<size_t>(voice % width), startPhase - std::floor(startPhase));
+        }
+
+        delayWritePos = 0;
+        samplesUntilControlUpdate = 0;
+        smoothersNeedReset = true;
+    }
+
+    void FanBank::processBlock(float *left, float *right, int numSamples)
+    {
+        JR_TRACE_SCOPE("FanBank::processBlock");
+
+        for (int start = 0; start < numSamples; start += maxBlockSize)
+            processSubBlock(nullptr, left + start, right + start, juce::jmin(maxBlockSize, numSamples - start));
+    }
+
+    void FanBank::processBlock(const float *speedScale, float *left, float *right, int numSamples)
+    {
+        JR_TRACE_SCOPE("FanBank::processBlock");
+
+        for (int start = 0; start < numSamples; start += maxBlockSize)
+            processSubBlock(speedScale + start, left + start, right + start, juce::jmin(maxBlockSize, numSamples - start));
+    }
+
+    //================= private methods =====================
+
+    void FanBank::processSubBlock(const float *speedScale, float *left, float *right, int numSamples)
+    {
+        if (smoothersNeedReset)
+        {
+            speed = targetSpeed;
+            gain = targetGain;
+            smoothersNeedReset = false;
+        }
+
+        const auto numGroups = getNumGroups(numVoices);
+
+        if (numGroups == 0)
+        {
+            juce::FloatVectorOperations::clear(left, numSamples);
+            juce::FloatVectorOperations::clear(right, numSamples);
+        }
+        else
+        {
+            const auto render = [this, speedScale, numSamples](int group) { renderGroup(static_cast<size_t>(group), speedScale, numSamples); };
+
+            if (workerPool != nullptr && numGroups > 1 && numSamples >= minParallelBlockSize)
+                workerPool->parallelFor(static_cast<int>(numGroups), render);
+            else
+                for (size_t group = 0; group < numGroups; group++)
+                    render(static_cast<int>(group));
+
+            // the groups are added into the mix of the first group, always in the same order
+            FloatVec *leftMix = groupMixLeft.data();
+            FloatVec *rightMix = groupMixRight.data();
+
+            for (size_t group = 1; group < numGroups; group++)
+            {
+                const FloatVec *groupLeft = leftMix + group * static_cast<size_t>(maxBlockSize);
+                const FloatVec *groupRight = rightMix + group * static_cast<size_t>(maxBlockSize);
+
+                for (int i = 0; i < numSamples; i++)
+                {
+                    leftMix[i] += groupLeft[i];
+                    rightMix[i] += groupRight[i];
+                }
+            }
+
+            // each register holds one sample of every voice in a group, so the mix is the sum of its lanes
+            for (int i = 0; i < numSamples; i++)
+            {
+                left[i] = leftMix[i].sum();
+                right[i] = rightMix[i].sum();
+            }
+        }
+
+        // the control updates are on a grid that carries on across blocks, so the output does not depend on the block size
+        const int untilControlUpdate = samplesUntilControlUpdate <= 0 ? controlInterval : samplesUntilControlUpdate;
+        samplesUntilControlUpdate = ((untilControlUpdate - numSamples) % controlInterval + controlInterval) % controlInterval;
+
+        delayWritePos = (delayWritePos + numSamples) & (delaySize - 1);
+    }
+
+    void FanBank::renderGroup(size_t group, const float *speedScale, int numSamples)
+    {
+        const auto one = FloatVec::expand(1.0f);
+        const auto half = FloatVec::expand(0.5f);
+
+        // lanes past numVoices in the last group are rendered but left out of the mix
+        alignas(FloatVec::SIMDRegisterSize) float activeLanes[width];
+        for (int lane = 0; lane < width; lane++)
+            activeLanes[lane] = static_cast<int>(group) * width + lane < numVoices ? 1.0f : 0.0f;
+        const auto isActive = FloatVec::fromRawArray(activeLanes);
+
+        // the state is held in registers for the whole block, and only written back at the end
+        auto currentSpeed = speed[group], currentGain = gain[group], currentPhase = phase[group];
+        auto coefficient = mainCoefficient[group], coefficientStep = mainCoefficientStep[group];
+        auto main1 = mainState1[group], main2 = mainState2[group], fast1 = fastState1[group], fast2 = fastState2[group];
+
+        const auto speedTarget = targetSpeed[group], gainTarget = targetGain[group], tone = toneLevel[group], noiseAmount = noiseLevel[group];
+        const auto widthAmount = panWidth[group], doppler = dopplerOn[group], k = damping[group];
+
+        // the fast blades filter is a fixed low pass, the same for every voice
+        const float fastA1 = 1.0f / (1.0f + fixedCoefficient * (fixedCoefficient + 1.0f / fixedResonance));
+        const float fastA2 = fixedCoefficient * fastA1;
+        const float fastA3 = fixedCoefficient * fastA2;
+
+        const float invSampleRate = 1.0f / sampleRate;
+        const float msToSamples = sampleRate / 1000.0f;
+        const float invControlInterval = 1.0f / static_cast<float>(controlInterval);
+
+        // two noise values for every voice each sample, one for each of the noise components
+        alignas(FloatVec::SIMDRegisterSize) float noiseValues[chunkSize * 2 * width];
+
+        FloatVec *leftOut = groupMixLeft.data() + group * static_cast<size_t>(maxBlockSize);
+        FloatVec *rightOut = groupMixRight.data() + group * static_cast<size_t>(maxBlockSize);
+
+        // every group follows the same control update grid from the start of the block, processSubBlock() moves it on afterwards
+        int untilControlUpdate = samplesUntilControlUpdate;
+
+        FloatVec *delayLine = delayBuffer.data() + group * static_cast<size_t>(delaySize);
+        const int delayMask = delaySize - 1;
+        alignas(FloatVec::SIMDRegisterSize) float delayTimes[width];
+        alignas(FloatVec::SIMDRegisterSize) float delayed[width];
+
+        for (int start = 0; start < numSamples; start += chunkSize)
+        {
+            const int numInChunk = juce::jmin(chunkSize, numSamples - start);
+            noise[group].fillUniform(noiseValues, numInChunk * 2 * width);
+
+            for (int j = 0; j < numInChunk; j++)
+            {
+                const int i = start + j;
+
+                if (speedScale != nullptr)
+                    currentSpeed = speedTarget * speedScale[i];
+                else
+                    currentSpeed = FloatVec::multiplyAdd(currentSpeed, speedTarget - currentSpeed, FloatVec::expand(speedSmoothing));
+
+                currentGain = FloatVec::multiplyAdd(currentGain, gainTarget - currentGain, FloatVec::expand(gainSmoothing));
+
+                // blade phase, wrapped back into 0-1
+                currentPhase = FloatVec::multiplyAdd(currentPhase, currentSpeed, FloatVec::expand(invSampleRate));
+                currentPhase = currentPhase - (one & FloatVec::greaterThanOrEqual(currentPhase, one));
+
+                // waveshaping technique of 1/(1 + x^2) used to obtain narrow pulse wave
+                const auto sine = SimdUtils::sin2Pi(currentPhase);
+                const auto x = sine * pulseWidth;
+                const auto rawSignal = SimdUtils::fastReciprocal(FloatVec::multiplyAdd(one, x, x));
+                const auto toneOut = rawSignal * tone;
+
+                // the doppler cutoff follows the blades at control rate, and the filter coefficient is ramped in between
+                if (untilControlUpdate <= 0)
+                    untilControlUpdate = controlInterval;
+
+                if (untilControlUpdate-- == controlInterval)
+                {
+                    const auto dopplerCutoff = FloatVec::multiplyAdd(FloatVec::expand(dopplerOffset), (sine + one) * half, FloatVec::expand(dopplerRange));
+                    const auto fixed = FloatVec::expand(fixedCoefficient);
+                    const auto target = FloatVec::multiplyAdd(fixed, doppler, cutoffToCoefficient(dopplerCutoff) - fixed);
+                    coefficientStep = (target - coefficient) * invControlInterval;
+                }
+                coefficient = coefficient + coefficientStep;
+
+                const auto noiseIn = FloatVec::fromRawArray(noiseValues + (2 * j) * width);
+                const auto fastNoiseIn = FloatVec::fromRawArray(noiseValues + (2 * j + 1) * width);
+
+                // main blades: band pass state variable filter, see StateVariableFilter
+                const auto a1 = SimdUtils::fastReciprocal(FloatVec::multiplyAdd(one, coefficient, coefficient + k));
+                const auto a2 = coefficient * a1;
+                const auto a3 = coefficient * a2;
+
+                const auto mainV3 = noiseIn - main2;
+                const auto mainV1 = FloatVec::multiplyAdd(a1 * main1, a2, mainV3);
+                const auto mainV2 = FloatVec::multiplyAdd(FloatVec::multiplyAdd(main2, a2, main1), a3, mainV3);
+                main1 = (mainV1 * 2.0f) - main1;
+                main2 = (mainV2 * 2.0f) - main2;
+
+                const auto mainOut = FloatVec::multiplyAdd(toneOut, k * mainV1, rawSignal * noiseAmount);
+
+                // fast blades: low pass state variable filter, then the delay modulated by the blades
+                const auto fastV3 = fastNoiseIn - fast2;
+                const auto fastV1 = FloatVec::multiplyAdd(fast1 * fastA1, fastV3, FloatVec::expand(fastA2));
+                const auto fastV2 = FloatVec::multiplyAdd(FloatVec::multiplyAdd(fast2, fast1, FloatVec::expand(fastA2)), fastV3, FloatVec::expand(fastA3));
+                fast1 = (fastV1 * 2.0f) - fast1;
+                fast2 = (fastV2 * 2.0f) - fast2;
+
+                const auto fastNoise = fastV2 * rawSignal * noiseAmount;
+
+                // each voice reads its delay line at a different time, so the read is done one lane at a time
+                const int writePos = (delayWritePos + i) & delayMask;
+                FloatVec::multiplyAdd(FloatVec::expand(delayTimeInMs), sine, FloatVec::expand(chopInMs)).copyToRawArray(delayTimes);
+
+                for (int lane = 0; lane < width; lane++)
+                {
+                    const float delay = juce::jmax(1.0f, delayTimes[lane] * msToSamples);
+                    const int wholeDelay = static_cast<int>(delay);
+                    const float fraction = delay - static_cast<float>(wholeDelay);
+
+                    const int indexA = (writePos - wholeDelay) & delayMask;
+                    const int indexB = (indexA - 1) & delayMask;
+
+                    delayed[lane] = ((1.0f - fraction) * delayLine[indexA].get(static_cast<size_t>(lane))) + (fraction * delayLine[indexB].get(static_cast<size_t>(lane)));
+                }
+
+                delayLine[writePos] = fastNoise;
+
+                const auto fastNoiseOut = FloatVec::multiplyAdd(fastNoise * (1.0f - delayWetMix), FloatVec::fromRawArray(delayed), FloatVec::expand(delayWetMix));
+                const auto fastOut = (toneOut + fastNoiseOut) * fastBladesLevel;
+
+                // the pan follows the main blades around centre, by the stereo width
+                const auto rightLevel = FloatVec::multiplyAdd(half - (widthAmount * half), (sine + one) * half, widthAmount);
+                const auto voiceOut = (mainOut + fastOut) * currentGain * isActive;
+
+                leftOut[i] = voiceOut * (one - rightLevel);
+                rightOut[i] = voiceOut * rightLevel;
+            }
+        }
+
+        speed[group] = currentSpeed;
+        gain[group] = currentGain;
+        phase[group] = currentPhase;
+        mainCoefficient[group] = coefficient;
+        mainCoefficientStep[group] = coefficientStep;
+        mainState1[group] = main1;
+        mainState2[group] = main2;
+        fastState1[group] = fast1;
+        fastState2[group] = fast2;
+    }
+
+    FanBank::FloatVec FanBank::cutoffToCoefficient(FloatVec cutoff) const
+    {
+        // see StateVariableFilter::cutoffToCoefficient() and StateVariableFilter::fastTan()
+        const auto limitedCutoff = FloatVec::max(FloatVec::expand(0.0f), FloatVec::min(cutoff, FloatVec::expand(0.45f * sampleRate)));
+        const auto x = limitedCutoff * (juce::MathConstants<float>::pi / sampleRate);
+        const auto x2 = x * x;
+
+        const auto numerator = x * FloatVec::multiplyAdd(FloatVec::expand(945.0f), x2, x2 - FloatVec::expand(105.0f));
+        const auto denominator = FloatVec::multiplyAdd(FloatVec::expand(945.0f), x2, (x2 * 15.0f) - FloatVec::expand(420.0f));
+
+        return numerator * SimdUtils::fastReciprocal(denominator);
+    }
+}
@@ -0,0 +1,150 @@
+#include <PhysicalModellingFan/components/audio/jr_FanSynth.h>
+#include <PhysicalModellingFan/utils/jr_Trace.h>
+#include <algorithm>
+
+namespace jr
+{
+    void FanSynth::prepare(float _sampleRate, int _maxBlockSize, int numVoices)
+    {
+        maxBlockSize = juce::jmax(1, _maxBlockSize);
+        voiceLeft.assign(static_cast<size_t>(maxBlockSize), 0.0f);
+        voiceRight.assign(static_cast<size_t>(maxBlockSize), 0.0f);
+
+        voices.resize(static_cast<size_t>(juce::jmax(1, numVoices)));
+
+        for (auto &voice : voices)
+        {
+            voice.machine.prepare(_sampleRate, maxBlockSize);
+            applyParameters(voice);
+        }
+    }
+
+    void FanSynth::setParameters(const MachineParameters &params)
+    {
+        sharedParameters = params;
+
+        // voices that have powered down pick up the parameters when their next note starts
+        for (auto &voice : voices)
+            if (!voice.machine.isIdle())
+                applyParameters(voice);
+    }
+
+    void FanSynth::noteOn(int note, float velocity)
+    {
+        auto &voice = findVoiceForNote(note);
+
+        voice.note = note;
+        voice.velocity = juce::jlimit(0.0f, 1.0f, velocity);
+        voice.isHeld = true;
+        voice.started = ++noteCounter;
+
+        applyParameters(voice);
+    }
+
+    void FanSynth::noteOff(int note)
+    {
+        for (auto &voice : voices)
+        {
+            if (voice.isHeld && voice.note == note)
+            {
+                voice.isHeld = false;
+                applyParameters(voice);
+            }
+        }
+    }
+
+    void FanSynth::allNotesOff()
+    {
+        for (auto &voice : voices)
+        {
+            if (voice.isHeld)
+            {
+                voice.isHeld = false;
+                applyParameters(voice);
+            }
+        }
+    }
+
+    void FanSynth::processBlock(float *left, float *right, int numSamples)
+    {
+        JR_TRACE_SCOPE("FanSynth::processBlock");
+
+        juce::FloatVectorOperations::clear(left, numSamples);
+        juce::FloatVectorOperations::clear(right, numSamples);
+
+        for (auto &voice : voices)
+        {
+            // a voice that has powered down would only render silence
+            if (voice.machine.isIdle())
+                continue;
+
+            for (int start = 0; start < numSamples; start += maxBlockSize)
+            {
+                const int numToRender = juce::jmin(maxBlockSize, numSamples - start);
+                voice.machine.processBlock(voiceLeft.data(), voiceRight.data(), numToRender);
+
+                juce::FloatVectorOperations::add(left + start, voiceLeft.data(), numToRender);
+                juce::FloatVectorOperations::add(right + start, voiceRight.data(), numToRender);
+            }
+        }
+    }
+
+    void FanSynth::setSeed(uint64_t seed)
+    {
+        for (size_t i = 0; i < voices.size(); i++)
+            voices[i].machine.setSeed(seed + i);
+    }
+
+    bool FanSynth::isNoteHeld(int note) const
+    {
+        return std::any_of(voices.begin(), voices.end(), [note](const Voice &voice)
+                           { return voice.isHeld && voice.note == note; });
+    }
+
+    int FanSynth::getNumActiveVoices() const
+    {
+        return static_cast<int>(std::count_if(voices.begin(), voices.end(), [](const Voice &voice)
+                                              { return !voice.machine.isIdle(); }));
+    }
+
+    //================= private methods =====================
+
+    FanSynth::Voice &FanSynth::findVoiceForNote(int note)
+    {
+        // a note that is still sounding restarts on the same voice, rather than doubling up
+        for (auto &voice : voices)
+            if (voice.note == note && !voice.machine.isIdle())
+                return voice;
+
+        for (auto &voice : voices)
+            if (voice.machine.isIdle())
+                return voice;
+
+        // every voice is sounding, so the quietest one is taken over, and the oldest of those if several are equally quiet
+        auto *quietest = &voices.front();
+
+        for (auto &voice : voices)
+        {
+            const float envelope = voice.machine.getEnvelopeValue();
+            const float quietestEnvelope = quietest->machine.getEnvelopeValue();
+
+            if (envelope < quietestEnvelope || (envelope == quietestEnvelope && voice.started < quietest->started))
+                quietest = &voice;
+        }
+
+        return *quietest;
+    }
+
+    void FanSynth::applyParameters(Voice &voice)
+    {
+        auto params = sharedParameters;
+
+        // the speed doubles for each octave above rootNote
+        const float noteRatio = std::exp2(static_cast<float>(voice.note - rootNote) / 12.0f);
+        params.speed = juce::jlimit(minSpeed, maxSpeed, sharedParameters.speed * noteRatio);
+        params.gain = sharedParameters.gain * voice.velocity;
+        params.powerOn = voice.isHeld;
+
+        voice.machine.setParameters(params);
+    }
+}
@@ -1,7 +1,89 @@
 #include <PhysicalModellingFan/components/audio/jr_Machine.h>
+#include <PhysicalModellingFan/ParameterIDs.h>
+#include <PhysicalModellingFan/utils/jr_Trace.h>
+#include <array>
 
 namespace jr
 {
+    void MachineParameters::set(MachineParameterId id, float value)
+    {
+        switch (id)
+        {
+        case MachineParameterId::gain:
+            gain = value;
+            break;
+        case MachineParameterId::speed:
+            speed = value;
+            break;
+        case MachineParameterId::toneLevel:
+            toneLevel = value;
+            break;
+        case MachineParameterId::noiseLevel:
+            noiseLevel = value;
+            break;
+        case MachineParameterId::stereoWidth:
+            stereoWidth = value;
+            break;
+        case MachineParameterId::powerUpTime:
+            powerUpTime = value;
+            break;
+        case MachineParameterId::powerDownTime:
+            powerDownTime = value;
+            break;
+        case MachineParameterId::dopplerOn:
+            dopplerOn = value >= 0.5f;
+            break;
+        case MachineParameterId::powerOn:
+            powerOn = value >= 0.5f;
+            break;
+        }
+    }
+
+    void MachineParameters::readPreset(const juce::XmlElement &xml)
+    {
+        for (const auto *param : xml.getChildWithTagNameIterator("PARAM"))
+        {
+            // parameters the Machine does not use, such as ACCEL_RATE, are skipped
+            if (const auto id = getId(param->getStringAttribute("id")))
+                set(*id, static_cast<float>(param->getDoubleAttribute("value")));
+        }
+    }
+
+    juce::Result MachineParameters::loadPreset(const juce::File &file)
+    {
+        if (!file.existsAsFile())
+            return juce::Result::fail("Preset file: " + file.getFullPathName() + " does not exist");
+
+        const auto xml = juce::parseXML(file);
+        if (xml == nullptr)
+            return juce::Result::fail("Preset file: " + file.getFullPathName() + " is not valid XML");
+
+        readPreset(*xml);
+
+        return juce::Result::ok();
+    }
+
+    std::optional<MachineParameterId> MachineParameters::getId(const juce::String &parameterId)
+    {
+        static const std::array<std::pair<juce::String, MachineParameterId>, 9> ids{{
+            {ID::GAIN, MachineParameterId::gain},
+            {ID::SPEED, MachineParameterId::speed},
+            {ID::FAN_TONE, MachineParameterId::toneLevel},
+            {ID::FAN_NOISE, MachineParameterId::noiseLevel},
+            {ID::FAN_WIDTH, MachineParameterId::stereoWidth},
+            {ID::POWER_UP_T, MachineParameterId::powerUpTime},
+            {ID::POWER_DOWN_T, MachineParameterId::powerDownTime},
+            {ID::FAN_DOPPLER, MachineParameterId::dopplerOn},
+            {ID::POWER, MachineParameterId::powerOn},
+        }};
+
+        for (const auto &[name, id] : ids)
+            if (name == parameterId)
+                return id;
+
+        return std::nullopt;
+    }
+
     void Machine::setSampleRate(float _sampleRate)
     {
         if (_sampleRate > 0)
@@ -9,16 +91,203 @@ namespace jr
             envelope.setSampleRate(_sampleRate);
             fan.setSampleRate(_sampleRate);
             gain.reset(_sampleRate, gainSmoothingInS);
+            maxSpeed.reset(_sampleRate, speedSmoothingInS);
+        }
+    }
+
+    void Machine::prepare(float _sampleRate, int _maxBlockSize)
+    {
+        setSampleRate(_sampleRate);
+
+        maxBlockSize = juce::jmax(1, _maxBlockSize);
+        fan.setMaxBlockSize(maxBlockSize);
+        envelopeBuffer.assign(static_cast<size_t>(maxBlockSize), 0.0f);
+        speedBuffer.assign(static_cast<size_t>(maxBlockSize), 0.0f);
+
+        parametersNeedFullUpdate = true;
+    }
+
+    void Machine::setParameters(const MachineParameters &params)
+    {
+        const bool all = parametersNeedFullUpdate;
+
+        if (all || params.gain != lastParameters.gain)
+            setParameter(MachineParameterId::gain, params.gain);
+        if (all)
+            maxSpeed.setCurrentAndTargetValue(params.speed); // nothing to smooth from after prepare()
+        else if (params.speed != lastParameters.speed)
+            setParameter(MachineParameterId::speed, params.speed);
+        if (all || params.toneLevel != lastParameters.toneLevel)
+            setParameter(MachineParameterId::toneLevel, params.toneLevel);
+        if (all || params.noiseLevel != lastParameters.noiseLevel)
+            setParameter(MachineParameterId::noiseLevel, params.noiseLevel);
+        if (all || params.stereoWidth != lastParameters.stereoWidth)
+            setParameter(MachineParameterId::stereoWidth, params.stereoWidth);
+        if (all || params.dopplerOn != lastParameters.dopplerOn)
+            setParameter(MachineParameterId::dopplerOn, params.dopplerOn ? 1.0f : 0.0f);
+
+        // setting the envelope times restarts the power up curve, so these are never forced
+        if (params.powerUpTime != lastParameters.powerUpTime)
+            setParameter(MachineParameterId::powerUpTime, params.powerUpTime);
+        if (params.powerDownTime != lastParameters.powerDownTime)
+            setParameter(MachineParameterId::powerDownTime, params.powerDownTime);
+
+        // the envelope keeps running through prepare(), and setParameter() only toggles power when the envelope state differs
+        if (all || params.powerOn != lastParameters.powerOn)
+            setParameter(MachineParameterId::powerOn, params.powerOn ? 1.0f : 0.0f);
+
+        lastParameters = params;
+        parametersNeedFullUpdate = false;
+    }
+
+    void Machine::setParameter(MachineParameterId id, float value)
+    {
+        switch (id)
+        {
+        case MachineParameterId::gain:
+            setGain(value);
+            break;
+        case MachineParameterId::speed:
+            setSpeed(value);
+            break;
+        case MachineParameterId::toneLevel:
+            setFanToneLevel(value);
+            break;
+        case MachineParameterId::noiseLevel:
+            setFanNoiseLevel(value);
+            break;
+        case MachineParameterId::stereoWidth:
+            setFanStereoWidth(value);
+            break;
+        case MachineParameterId::powerUpTime:
+            setPowerUpTime(value);
+            break;
+        case MachineParameterId::powerDownTime:
+            setPowerDownTime(value);
+            break;
+        case MachineParameterId::dopplerOn:
+            setFanDoppler(value >= 0.5f);
+            break;
+        case MachineParameterId::powerOn:
+            if ((value >= 0.5f) != envelope.getIsPowerOn())
+                togglePower(value >= 0.5f);
+            break;
         }
     }
 
-    void Machine::process()
+    void Machine::processBlock(float *left, float *right, int numSamples)
     {
-        envelope.process();
-        fan.process(envelope.getCurrentValue());
-        gain.getNextValue();
+        JR_TRACE_SCOPE("Machine::processBlock");
+        jassert(maxBlockSize > 0); // prepare() must be called before processing
+
+        // a sub-block ends on the sample where the envelope falls to 0, so the machine goes idle on that sample whatever the block size
+        for (int start = 0; start < numSamples;)
+        {
+            if (isIdle())
+            {
+                // the fan state is cleared once so it starts from silence on the next power on, then nothing is processed until then
+                if (!fanIsReset)
+                {
+                    fan.reset();
+                    fanIsReset = true;
+                }
 
-        currentSampleLeft = gain.getCurrentValue() * fan.getLeftSample() * envelope.getCurrentValue();
-        currentSampleRight = gain.getCurrentValue() * fan.getRightSample() * envelope.getCurrentValue();
+                // nothing can be heard while idle, so the smoothers jump to their targets (skipping part of a ramp would depend on the block size)
+                gain.setCurrentAndTargetValue(gain.getTargetValue());
+                maxSpeed.setCurrentAndTargetValue(maxSpeed.getTargetValue());
+
+                // the power can only come back on between calls, so the rest of the block is silent
+                juce::FloatVectorOperations::clear(left + start, numSamples - start);
+                juce::FloatVectorOperations::clear(right + start, numSamples - start);
+                return;
+            }
+
+            fanIsReset = false;
+            start += processSubBlock(left + start, right + start, juce::jmin(maxBlockSize, numSamples - start));
+        }
+    }
+
+    void Machine::processBlock(float *left, float *right, int numSamples, const MachineParameterEvent *events, int numEvents)
+    {
+        int start = 0;
+
+        for (int i = 0; i < numEvents; i++)
+        {
+            jassert(i == 0 || events[i].sampleOffset >= events[i - 1].sampleOffset); // events must be sorted
+
+            const int offset = juce::jlimit(start, numSamples, events[i].sampleOffset);
+
+            if (offset > start)
+            {
+                processBlock(left + start, right + start, offset - start);
+                start = offset;
+            }
+
+            setParameter(events[i].id, events[i].value);
+        }
+
+        if (start < numSamples)
+            processBlock(left + start, right + start, numSamples - start);
+    }
+
+    size_t Machine::getStateSize() const
+    {
+        StateArchive archive(StateArchive::Mode::measure);
+
+        // measuring only reads the members
+        const_cast<Machine &>(*this).serialiseState(archive);
+        return archive.getPosition();
+    }
+
+    bool Machine::saveState(void *dest, size_t destSize) const
+    {
+        StateArchive archive(StateArchive::Mode::save, dest, destSize);
+
+        // saving only reads the members
+        const_cast<Machine &>(*this).serialiseState(archive);
+        return archive.isOk();
+    }
+
+    bool Machine::restoreState(const void *src, size_t srcSize)
+    {
+        // the whole state is checked before anything is changed, so a state saved at another sample rate or a damaged one leaves the machine as it was
+        StateArchive check(StateArchive::Mode::verify, const_cast<void *>(src), srcSize);
+        serialiseState(check);
+
+        if (!check.isOk() || check.getPosition() != srcSize)
+            return false;
+
+        StateArchive archive(StateArchive::Mode::restore, const_cast<void *>(src), srcSize);
+        serialiseState(archive);
+        return archive.isOk();
+    }
+
+    int Machine::processSubBlock(float *left, float *right, int maxSamples)
+    {
+        const int numSamples = envelope.processBlockUntilSilent(envelopeBuffer.data(), maxSamples);
+
+        // current speed of the fan follows the motor envelope
+        for (int i = 0; i < numSamples; i++)
+            speedBuffer[static_cast<size_t>(i)] = envelopeBuffer[static_cast<size_t>(i)] * maxSpeed.getNextValue();
+
+        fan.processBlock(speedBuffer.data(), left, right, numSamples);
+
+        for (int i = 0; i < numSamples; i++)
+        {
+            float currentGain = gain.getNextValue();
+            float currentEnvelope = envelopeBuffer[static_cast<size_t>(i)];
+
+            left[i] = currentGain * left[i] * currentEnvelope;
+            right[i] = currentGain * right[i] * currentEnvelope;
+        }
+
+        return numSamples;
+    }
+
+    void Machine::serialiseState(StateArchive &archive)
+    {
+        archive.expect(stateVersion);
+        archive(envelope, gain, gainSmoothingInS, maxSpeed, speedSmoothingInS, lastParameters, parametersNeedFullUpdate, fanIsReset);
+        fan.serialiseState(archive);
     }
 }
\ No newline at end of file
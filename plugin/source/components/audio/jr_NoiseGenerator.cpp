@@ -0,0 +1,112 @@
+/*
+  ==============================================================================
+
+    jr_NoiseGenerator.cpp
+
+  ==============================================================================
+*/
+
+#include <PhysicalModellingFan/components/audio/jr_NoiseGenerator.h>
+#include <juce_core/juce_core.h>
+#include <atomic>
+
+namespace jr
+{
+    namespace
+    {
+        /** splitmix64, used to expand a single seed into the lane states */
+        uint64_t splitMix64(uint64_t &state)
+        {
+            uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            return z ^ (z >> 31);
+        }
+
+        constexpr float uniformScale{1.0f / 16777216.0f}; // 2^-24, maps the top 24 bits of a value to 0-1
+        constexpr float gaussianScale{1.7320508f};         // sqrt(3), scales the sum of four uniforms to unit variance
+    }
+
+    NoiseGenerator::NoiseGenerator()
+    {
+        // every instance gets a different default seed, without sharing a random number generator between threads
+        static std::atomic<uint64_t> instanceCount{};
+        const uint64_t instanceIndex = instanceCount.fetch_add(1, std::memory_order_relaxed);
+
+        setSeed(static_cast<uint64_t>(juce::Time::getHighResolutionTicks()) ^ (instanceIndex * 0x9e3779b97f4a7c15ULL));
+    }
+
+    void NoiseGenerator::setSeed(uint64_t seed)
+    {
+        for (int lane = 0; lane < numLanes; lane++)
+        {
+            const uint64_t a = splitMix64(seed);
+            const uint64_t b = splitMix64(seed);
+
+            s0[lane] = static_cast<uint32_t>(a);
+            s1[lane] = static_cast<uint32_t>(a >> 32);
+            s2[lane] = static_cast<uint32_t>(b);
+            s3[lane] = static_cast<uint32_t>(b >> 32) | 1u; // state must not be all zero
+        }
+
+        numPending = 0;
+    }
+
+    void NoiseGenerator::nextBatch(float *out)
+    {
+        for (int lane = 0; lane < numLanes; lane++)
+        {
+            const uint32_t result = s0[lane] + s3[lane];
+            const uint32_t t = s1[lane] << 9;
+
+            s2[lane] ^= s0[lane];
+            s3[lane] ^= s1[lane];
+            s1[lane] ^= s2[lane];
+            s0[lane] ^= s3[lane];
+            s2[lane] ^= t;
+            s3[lane] = (s3[lane] << 11) | (s3[lane] >> 21);
+
+            // xoshiro128+ has weak low bits, so only the top 24 are used
+            out[lane] = static_cast<float>(static_cast<int32_t>(result >> 8)) * uniformScale;
+        }
+    }
+
+    void NoiseGenerator::fillUniform(float *out, int numSamples)
+    {
+        int i = 0;
+
+        // use up what is left of the previous batch first, so the sequence does not depend on block sizes
+        for (; i < numSamples && numPending > 0; i++, numPending--)
+            out[i] = pending[numLanes - numPending];
+
+        for (; i + numLanes <= numSamples; i += numLanes)
+            nextBatch(out + i);
+
+        if (i < numSamples)
+        {
+            nextBatch(pending);
+            numPending = numLanes;
+
+            for (; i < numSamples; i++, numPending--)
+                out[i] = pending[numLanes - numPending];
+        }
+    }
+
+    void NoiseGenerator::fillGaussian(float *out, int numSamples)
+    {
+        constexpr int chunkSize{64};
+        float uniforms[chunkSize * 4];
+
+        for (int start = 0; start < numSamples; start += chunkSize)
+        {
+            const int numInChunk = juce::jmin(chunkSize, numSamples - start);
+            fillUniform(uniforms, numInChunk * 4);
+
+            for (int i = 0; i < numInChunk; i++)
+            {
+                const float sum = uniforms[4 * i] + uniforms[4 * i + 1] + uniforms[4 * i + 2] + uniforms[4 * i + 3];
+                out[start + i] = (sum - 2.0f) * gaussianScale;
+            }
+        }
+    }
+}
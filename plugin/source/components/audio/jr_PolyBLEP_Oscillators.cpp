@@ -9,14 +9,120 @@
 */
 
 #include <PhysicalModellingFan/components/audio/jr_PolyBLEP_Oscillators.h>
+#include <PhysicalModellingFan/utils/jr_simdUtils.h> // used for juce::dsp::SIMDRegister and the sine kernel
+#include <PhysicalModellingFan/utils/jr_StateArchive.h> // used for StateArchive
+#include <algorithm>		   // used for std::min() and std::max()
 
 namespace jr
 {
+	//================================ Waveform Kernels ===================================//
 
-	//================================ Oscillator Class ===================================//
+	namespace
+	{
+		using FloatVec = juce::dsp::SIMDRegister<float>;
+		using OscillatorMode = Oscillator::OscillatorMode;
+
+		constexpr int simdWidth = static_cast<int>(FloatVec::SIMDNumElements);
+		constexpr int chunkSize = 64; // samples per kernel pass, small enough for the scratch arrays to live on the stack
+		static_assert(chunkSize % simdWidth == 0, "chunk size must be a whole number of SIMD registers");
+
+		/** Converts a 0.32 fixed point phase to a float in the range 0-1, exact since only the top 24 bits are kept */
+		inline float phaseToFloat(uint32_t fixedPointPhase)
+		{
+			return static_cast<float>(static_cast<int32_t>(fixedPointPhase >> 8)) * (1.0f / 16777216.0f);
+		}
+
+		/**
+		 * Branchless polyBLEP residual, equal to 2x - x^2 - 1 with x = t/dt when t < dt, x^2 + 2x + 1 with x = (t-1)/dt when t > 1 - dt, and 0 otherwise
+		 * @param t - phase (0-1)
+		 * @param invDt - 1 / phase increment
+		 */
+		inline FloatVec polyBLEP(FloatVec t, FloatVec invDt)
+		{
+			auto zero = FloatVec::expand(0.0f);
+			auto one = FloatVec::expand(1.0f);
 
-	// initialise static member outside of class to a default value
-	double Oscillator::sampleRate{44100};
+			auto rising = FloatVec::max(zero, one - t * invDt);
+			auto falling = FloatVec::max(zero, one + (t - 1.0f) * invDt);
+
+			return (falling * falling) - (rising * rising);
+		}
+
+		/** naive square wave, 1 for the first half of the cycle and -1 for the second */
+		inline FloatVec squareKernel(FloatVec t)
+		{
+			return FloatVec::expand(1.0f) - (FloatVec::expand(2.0f) & FloatVec::greaterThan(t, FloatVec::expand(0.5f)));
+		}
+
+		/**
+		 * Renders a waveform from a buffer of phases, numSamples must be a whole number of SIMD registers and all buffers SIMD aligned
+		 * @param t - phase of each sample (0-1)
+		 * @param invDt - 1 / phase increment of each sample, only read by the anti-aliased modes
+		 * @param out - buffer for the waveform
+		 */
+		template <OscillatorMode mode, bool antiAliased>
+		void renderWaveform(const float *t, const float *invDt, float *out, int numSamples)
+		{
+			for (int i = 0; i < numSamples; i += simdWidth)
+			{
+				auto phaseVec = FloatVec::fromRawArray(t + i);
+				FloatVec sampleOut;
+
+				if constexpr (mode == OscillatorMode::SINE)
+				{
+					sampleOut = SimdUtils::sin2Pi(phaseVec);
+				}
+				else if constexpr (mode == OscillatorMode::SAW)
+				{
+					sampleOut = (phaseVec * 2.0f) - 1.0f;
+
+					if constexpr (antiAliased)
+						sampleOut = sampleOut - polyBLEP(phaseVec, FloatVec::fromRawArray(invDt + i));
+				}
+				else if constexpr (mode == OscillatorMode::TRIANGLE && !antiAliased)
+				{
+					auto centred = phaseVec - 0.5f;
+					sampleOut = FloatVec::max(centred, FloatVec::expand(0.0f) - centred) * 4.0f;
+				}
+				else
+				{
+					// square wave, also the input to the leaky integrator of the anti-aliased triangle wave
+					sampleOut = squareKernel(phaseVec);
+
+					if constexpr (antiAliased)
+					{
+						auto invDtVec = FloatVec::fromRawArray(invDt + i);
+						auto halfPhase = (phaseVec + 0.5f) - (FloatVec::expand(1.0f) & FloatVec::greaterThanOrEqual(phaseVec, FloatVec::expand(0.5f)));
+						sampleOut = sampleOut + polyBLEP(phaseVec, invDtVec) - polyBLEP(halfPhase, invDtVec);
+					}
+				}
+
+				sampleOut.copyToRawArray(out + i);
+			}
+		}
+
+		template <bool antiAliased>
+		void renderWaveformForMode(OscillatorMode mode, const float *t, const float *invDt, float *out, int numSamples)
+		{
+			switch (mode)
+			{
+			default:
+				renderWaveform<OscillatorMode::SINE, antiAliased>(t, invDt, out, numSamples);
+				break;
+			case OscillatorMode::SAW:
+				renderWaveform<OscillatorMode::SAW, antiAliased>(t, invDt, out, numSamples);
+				break;
+			case OscillatorMode::SQUARE:
+				renderWaveform<OscillatorMode::SQUARE, antiAliased>(t, invDt, out, numSamples);
+				break;
+			case OscillatorMode::TRIANGLE:
+				renderWaveform<OscillatorMode::TRIANGLE, antiAliased>(t, invDt, out, numSamples);
+				break;
+			}
+		}
+	}
+
+	//================================ Oscillator Class ===================================//
 
 	//====================== Mutator Functions ===========================//
 
@@ -49,107 +155,96 @@ namespace jr
 
 	float Oscillator::processSingleSample()
 	{
-
-		double sampleOut{};
-
-		if (!isMuted)
-		{
-			sampleOut = naiveWaveformForMode(oscMode);
-		}
-
-		phase += phaseDelta;
-
-		if ((phase + phaseShift) >= 1)
-			phase -= 1;
-
-		return static_cast<float>(sampleOut);
+		float sampleOut{};
+		processNextBlock(&sampleOut, 1);
+		return sampleOut;
 	}
 
-	double Oscillator::naiveWaveformForMode(OscillatorMode mode)
+	void Oscillator::processNextBlock(float *buffer, int numSamples)
 	{
-		double value{};
-
-		switch (mode)
+		for (int start = 0; start < numSamples; start += chunkSize)
 		{
-		default:
-			// sine as default and case OscMode_Sine:
-			value = sin(twoPI * (phase + phaseShift));
-			break;
-		case OscillatorMode::SAW:
-			value = 2 * ((phase + phaseShift) - 0.5);
-			break;
-		case OscillatorMode::SQUARE:
-			value = 1;
-			if ((phase + phaseShift) > 0.5)
-				value = -1;
-			break;
-		case OscillatorMode::TRIANGLE:
-			value = 4 * fabs((phase + phaseShift) - 0.5);
-			break;
+			renderChunk(buffer + start, nullptr, std::min(chunkSize, numSamples - start));
 		}
-
-		return value;
 	}
 
-	void Oscillator::processNextBlock(float *buffer, int numSamples)
+	void Oscillator::processNextBlock(float *buffer, const float *frequencies, int numSamples)
 	{
-		for (size_t i = 0; i < numSamples; i++)
+		for (int start = 0; start < numSamples; start += chunkSize)
 		{
-			buffer[i] = processSingleSample();
+			renderChunk(buffer + start, frequencies + start, std::min(chunkSize, numSamples - start));
 		}
 	}
 
-	//============================ polyblepOscillator Class ===============================//
-
-	//======================= Accessor Functions =====================//
-
-	float polyblepOscillator::processSingleSample()
+	void Oscillator::serialiseState(StateArchive &archive)
 	{
-		double sampleOut{};
+		archive(sampleRate, oscMode, frequency, phase, phaseIncrement, isMuted, phaseShift, lastOutput);
+	}
 
-		if (oscMode == OscillatorMode::SINE)
+	void Oscillator::renderChunk(float *buffer, const float *frequencies, int numSamples)
+	{
+		alignas(FloatVec::SIMDRegisterSize) float phases[chunkSize];
+		alignas(FloatVec::SIMDRegisterSize) float invDeltas[chunkSize];
+		alignas(FloatVec::SIMDRegisterSize) float deltas[chunkSize];
+		alignas(FloatVec::SIMDRegisterSize) float waveform[chunkSize];
+		uint32_t fixedPointPhases[chunkSize];
+		uint32_t fixedPointIncrements[chunkSize];
+
+		// phase accumulation is the only sequential step, the waveform itself is rendered by the SIMD kernels below
+		const double incrementScale = phaseRange / sampleRate;
+		for (int i = 0; i < numSamples; i++)
 		{
-			sampleOut = naiveWaveformForMode(oscMode);
+			if (frequencies != nullptr && frequencies[i] > 0)
+			{
+				frequency = frequencies[i];
+				phaseIncrement = static_cast<uint32_t>(frequency * incrementScale);
+			}
+
+			fixedPointPhases[i] = phase + phaseShift;
+			fixedPointIncrements[i] = phaseIncrement;
+			phase += phaseIncrement;
 		}
-		else if (oscMode == OscillatorMode::SAW)
+
+		if (isMuted)
 		{
-			sampleOut = naiveWaveformForMode(oscMode);
-			sampleOut -= polyBLEP((phase + phaseShift));
+			std::fill(buffer, buffer + numSamples, 0.0f);
+			return;
 		}
-		else
+
+		// pad up to a whole number of SIMD registers with values that keep the kernels finite
+		const int paddedNumSamples = ((numSamples + simdWidth - 1) / simdWidth) * simdWidth;
+		const bool antiAliased = isAntiAliased();
+
+		for (int i = 0; i < paddedNumSamples; i++)
 		{
-			// square wave
-			sampleOut = naiveWaveformForMode(OscillatorMode::SQUARE);
-			sampleOut += polyBLEP((phase + phaseShift));
-			sampleOut -= polyBLEP(std::fmod((phase + phaseShift) + 0.5, 1.0)); // fmod() clamps phase between 0-1 whilst offsetting value by 0.5
+			phases[i] = i < numSamples ? phaseToFloat(fixedPointPhases[i]) : 0.0f;
+		}
 
-			if (oscMode == OscillatorMode::TRIANGLE)
+		if (antiAliased && oscMode != OscillatorMode::SINE)
+		{
+			for (int i = 0; i < paddedNumSamples; i++)
 			{
-				sampleOut = phaseDelta * sampleOut + (1 - phaseDelta) * lastOutput; // leaky integrator: multiplying by (1 - phaseDelta) instead of 1 to stop output from accumulating
-				lastOutput = sampleOut;
+				deltas[i] = i < numSamples ? phaseToFloat(fixedPointIncrements[i]) : 1.0f;
+				invDeltas[i] = 1.0f / std::max(deltas[i], 1.0e-7f);
 			}
 		}
 
-		phase += phaseDelta;
-		if ((phase + phaseShift) >= 1)
-			phase -= 1;
-
-		return static_cast<float>(sampleOut);
-	}
+		if (antiAliased)
+			renderWaveformForMode<true>(oscMode, phases, invDeltas, waveform, paddedNumSamples);
+		else
+			renderWaveformForMode<false>(oscMode, phases, invDeltas, waveform, paddedNumSamples);
 
-	double polyblepOscillator::polyBLEP(double t)
-	{
-		if (t < phaseDelta)
-		{
-			t /= phaseDelta;
-			return (t + t - (t * t) - 1.0);
-		}
-		else if (t > (1.0 - phaseDelta))
+		if (antiAliased && oscMode == OscillatorMode::TRIANGLE)
 		{
-			t = (t - 1.0) / phaseDelta;
-			return ((t * t) + t + t + 1.0);
+			// leaky integrator: multiplying by (1 - phaseDelta) instead of 1 to stop output from accumulating
+			// this is a recursive filter so it runs sample by sample after the square wave kernel
+			for (int i = 0; i < numSamples; i++)
+			{
+				lastOutput = deltas[i] * waveform[i] + (1.0f - deltas[i]) * lastOutput;
+				waveform[i] = lastOutput;
+			}
 		}
-		else
-			return 0.0;
+
+		std::copy(waveform, waveform + numSamples, buffer);
 	}
 };
\ No newline at end of file
@@ -0,0 +1,40 @@
+/*
+  ==============================================================================
+
+    jr_PulseShaper.cpp
+
+  ==============================================================================
+*/
+
+#include <PhysicalModellingFan/components/audio/jr_PulseShaper.h>
+#include <PhysicalModellingFan/utils/jr_simdUtils.h>
+
+namespace jr
+{
+    namespace
+    {
+        using FloatVec = SimdUtils::FloatVec;
+    }
+
+    template <bool useFastReciprocal>
+    void PulseShaper::processWith(const float *sineIn, float pulseWidth, float level, float *rawSignalOut, float *out, int numSamples)
+    {
+        const auto one = FloatVec::expand(1.0f);
+
+        for (int i = 0; i < numSamples; i += SimdUtils::width)
+        {
+            const int numValues = juce::jmin(SimdUtils::width, numSamples - i);
+
+            auto x = SimdUtils::load(sineIn + i, numValues) * pulseWidth;
+            auto denominator = FloatVec::multiplyAdd(one, x, x); // 1 + x^2
+
+            auto rawSignal = useFastReciprocal ? SimdUtils::fastReciprocal(denominator) : SimdUtils::exactReciprocal(denominator);
+
+            SimdUtils::store(rawSignal, rawSignalOut + i, numValues);
+            SimdUtils::store(rawSignal * level, out + i, numValues);
+        }
+    }
+
+    template void PulseShaper::processWith<true>(const float *, float, float, float *, float *, int);
+    template void PulseShaper::processWith<false>(const float *, float, float, float *, float *, int);
+}
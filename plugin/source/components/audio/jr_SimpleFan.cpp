@@ -9,59 +9,95 @@
 */
 
 #include <PhysicalModellingFan/components/audio/jr_SimpleFan.h>
+#include <PhysicalModellingFan/utils/jr_Trace.h>
 
 namespace jr
 {
 
     //======================= Tone Component =========================//
 
-    float FanToneComponent::process()
+    void FanToneComponent::serialiseState(StateArchive &archive)
     {
-        rawSineSignal = sineOsc.processSingleSample();
+        sineOsc.serialiseState(archive);
+        archive(phaseShift, pulseWidth, level);
+    }
 
-        // waveshaping technique of 1/(1 + x^2) used to obtain narrow pulse wave
-        rawSignal = static_cast<float>(1.0 / (1.0 + pow(rawSineSignal * pulseWidth, 2)));
+    void FanToneComponent::processBlock(const float *speedIn, float *rawSineOut, float *rawSignalOut, float *out, int numSamples)
+    {
+        sineOsc.processNextBlock(rawSineOut, speedIn, numSamples);
 
-        return rawSignal * level;
+        // waveshaping technique of 1/(1 + x^2) used to obtain narrow pulse wave
+        PulseShaper::process(rawSineOut, pulseWidth, level, rawSignalOut, out, numSamples);
     }
 
     //======================= Noise Component =========================//
 
     void FanNoiseComponent::setFilterParams(float freq, float q)
     {
-        if (freq > 0)
+        if (freq > 0 && freq != cutoff)
+        {
             cutoff = freq;
+            coefficientsNeedUpdate = true;
+        }
 
-        if (q > 0)
+        if (q > 0 && q != resonance)
+        {
             resonance = q;
+            coefficientsNeedUpdate = true;
+        }
     }
 
-    float FanNoiseComponent::process(float rawSignalIn)
+    void FanNoiseComponent::serialiseState(StateArchive &archive)
     {
-        switch (filterType)
+        archive(cutoff, resonance, filter, coefficientsNeedUpdate, sampleRate, noise, level, filterType);
+    }
+
+    void FanNoiseComponent::processBlock(const float *rawSignalIn, float *out, int numSamples)
+    {
+        if (coefficientsNeedUpdate)
         {
-        default:
-            filter.setCoefficients(juce::IIRCoefficients::makeBandPass(sampleRate, cutoff, resonance));
-            break;
-        case 1:
-            filter.setCoefficients(juce::IIRCoefficients::makeLowPass(sampleRate, cutoff, resonance));
-            break;
+            JR_TRACE_SCOPE("FanNoiseComponent::updateCoefficients");
+            filter.setParams(cutoff, resonance);
+            coefficientsNeedUpdate = false;
         }
 
-        float filteredNoise = filter.processSingleSampleRaw(random.nextFloat());
+        // the output buffer holds the white noise until it is filtered in place
+        noise.fillUniform(out, numSamples);
 
-        float sampleOut = filteredNoise * rawSignalIn;
+        // the filter type is only looked up once per block, so the inner loop has no branches
+        using RenderFunction = void (FanNoiseComponent::*)(const float *, float *, int);
+        static constexpr RenderFunction renderForFilterType[] = {&FanNoiseComponent::renderNoise<bandPassType>,
+                                                                 &FanNoiseComponent::renderNoise<lowPassType>};
 
-        return sampleOut * level;
+        (this->*renderForFilterType[filterType])(rawSignalIn, out, numSamples);
+    }
+
+    template <size_t type>
+    void FanNoiseComponent::renderNoise(const float *rawSignalIn, float *out, int numSamples)
+    {
+        for (int i = 0; i < numSamples; i++)
+        {
+            float filteredNoise = filterSample<type>(out[i]);
+
+            out[i] = filteredNoise * rawSignalIn[i] * level;
+        }
     }
 
     //======================= Panner Component =========================//
 
-    void FanPanner::process(float controlSignalIn)
+    void FanPanner::processBlock(const float *controlSignalIn, const float *monoIn, float *leftOut, float *rightOut, int numSamples)
     {
-        rightLevel = (((controlSignalIn + 1.0f) / 2.0f) * panWidth) + 0.5f - (panWidth / 2.0f);
+        jassert(rightOut != monoIn);
+
+        // the right output buffer holds the right channel level until the signal is applied
+        rightLevel.process(rightOut, numSamples, [&](int i)
+                           { return (((controlSignalIn[i] + 1.0f) / 2.0f) * panWidth) + 0.5f - (panWidth / 2.0f); });
 
-        leftLevel = 1.0f - rightLevel;
+        for (int i = 0; i < numSamples; i++)
+        {
+            leftOut[i] = monoIn[i] * (1.0f - rightOut[i]);
+            rightOut[i] = monoIn[i] * rightOut[i];
+        }
     }
 
     //======================= Doppler Component =========================//
@@ -80,29 +116,60 @@ namespace jr
             dopplerCutoff = 0;
     }
 
-    float FanDopplerComponent::process(float rawSignalIn)
+    void FanDopplerComponent::serialiseState(StateArchive &archive)
+    {
+        FanNoiseComponent::serialiseState(archive);
+        archive(cutoffRange, cutoffOffset, dopplerCutoff, dopplerRes, dopplerOn, dopplerCoefficient);
+    }
+
+    void FanDopplerComponent::processBlock(const float *rawSignalIn, const float *controlSignalIn, float *out, int numSamples)
     {
-        if (dopplerOn)
+        if (!dopplerOn)
         {
-            switch (filterType)
+            FanNoiseComponent::processBlock(rawSignalIn, out, numSamples);
+            return;
+        }
+
+        filter.setResonance(dopplerRes);
+        noise.fillUniform(out, numSamples);
+
+        using RenderFunction = void (FanDopplerComponent::*)(const float *, const float *, float *, int);
+        static constexpr RenderFunction renderForFilterType[] = {&FanDopplerComponent::renderDoppler<bandPassType>,
+                                                                 &FanDopplerComponent::renderDoppler<lowPassType>};
+
+        (this->*renderForFilterType[filterType])(rawSignalIn, controlSignalIn, out, numSamples);
+
+        // the filter now holds the doppler coefficient, so the fixed cutoff must be restored if doppler is turned off
+        coefficientsNeedUpdate = true;
+    }
+
+    template <size_t type>
+    void FanDopplerComponent::renderDoppler(const float *rawSignalIn, const float *controlSignalIn, float *out, int numSamples)
+    {
+        constexpr int chunkSize{64};
+        float coefficients[chunkSize];
+
+        for (int start = 0; start < numSamples; start += chunkSize)
+        {
+            const int numInChunk = juce::jmin(chunkSize, numSamples - start);
+
+            // the cutoff only follows the control signal at control rate, and the coefficient is ramped in between
             {
-            default:
-                filter.setCoefficients(juce::IIRCoefficients::makeBandPass(sampleRate, dopplerCutoff, dopplerRes));
-                break;
-            case 1:
-                filter.setCoefficients(juce::IIRCoefficients::makeLowPass(sampleRate, dopplerCutoff, dopplerRes));
-                break;
+                JR_TRACE_SCOPE("FanDopplerComponent::updateCoefficients");
+                dopplerCoefficient.process(coefficients, numInChunk, [&](int i)
+                                           {
+                                               setDopplerParams(controlSignalIn[start + i]);
+                                               return filter.cutoffToCoefficient(dopplerCutoff); });
             }
 
-            float filteredNoise = filter.processSingleSampleRaw(random.nextFloat());
+            for (int i = 0; i < numInChunk; i++)
+            {
+                filter.setCoefficient(coefficients[i]);
 
-            float sampleOut = filteredNoise * rawSignalIn;
+                float filteredNoise = filterSample<type>(out[start + i]);
 
-            return sampleOut * level;
-        }
-        else
-        {
-            return FanNoiseComponent::process(rawSignalIn);
+                out[start + i] = filteredNoise * rawSignalIn[start + i] * level;
+            }
         }
     }
 
@@ -116,13 +183,31 @@ namespace jr
         delayLine.setSize(0.4f);
     }
 
-    float FanDelay::process(float controlSignalIn, float audioSignalIn)
+    void FanDelay::processBlock(const float *controlSignalIn, const float *audioSignalIn, float *out, int numSamples)
     {
-        float delayTimeInMs = 200 + (controlSignalIn * chop);
+        constexpr int chunkSize{64};
+        float delayTimes[chunkSize];
+
+        const float msToSamples = sampleRate / 1000.0f;
+
+        for (int start = 0; start < numSamples; start += chunkSize)
+        {
+            const int numInChunk = juce::jmin(chunkSize, numSamples - start);
 
-        delayLine.setDelayTime(delayTimeInMs / 1000.0f);
+            delayTime.process(delayTimes, numInChunk, [&](int i)
+                              {
+                                  float delayTimeInMs = 200 + (controlSignalIn[start + i] * chop);
+                                  return delayTimeInMs * msToSamples; });
 
-        return delayLine.process(audioSignalIn);
+            delayLine.process(audioSignalIn + start, delayTimes, out + start, numInChunk);
+        }
+    }
+
+    void FanDelay::serialiseState(StateArchive &archive)
+    {
+        archive.expect(sampleRate);
+        archive(chop, delayTime);
+        delayLine.serialiseState(archive);
     }
 
     //======================== Main Blades ==========================//
@@ -133,11 +218,30 @@ namespace jr
         noiseComp.setSampleRate(_sampleRate);
     }
 
-    float MainBlades::process()
+    void MainBlades::setMaxBlockSize(int maxBlockSize)
     {
-        float toneOut = toneComp.process();
-        setDopplerParams();
-        return level * (toneOut + noiseComp.process(toneComp.getRawSignal()));
+        rawSineBuffer.assign(static_cast<size_t>(maxBlockSize), 0.0f);
+        rawSignalBuffer.assign(static_cast<size_t>(maxBlockSize), 0.0f);
+        noiseBuffer.assign(static_cast<size_t>(maxBlockSize), 0.0f);
+    }
+
+    void MainBlades::serialiseState(StateArchive &archive)
+    {
+        archive(level);
+        toneComp.serialiseState(archive);
+        noiseComp.serialiseState(archive);
+    }
+
+    void MainBlades::processBlock(const float *speedIn, float *out, int numSamples)
+    {
+        JR_TRACE_SCOPE("MainBlades::processBlock");
+        jassert(numSamples <= static_cast<int>(noiseBuffer.size()));
+
+        toneComp.processBlock(speedIn, rawSineBuffer.data(), rawSignalBuffer.data(), out, numSamples);
+        noiseComp.processBlock(rawSignalBuffer.data(), rawSineBuffer.data(), noiseBuffer.data(), numSamples);
+
+        for (int i = 0; i < numSamples; i++)
+            out[i] = level * (out[i] + noiseBuffer[static_cast<size_t>(i)]);
     }
 
     //======================== Fast Blades ==========================//
@@ -155,11 +259,32 @@ namespace jr
         delayComp.setSampleRate(_sampleRate);
     }
 
-    float FastBlades::process()
+    void FastBlades::setMaxBlockSize(int maxBlockSize)
+    {
+        rawSineBuffer.assign(static_cast<size_t>(maxBlockSize), 0.0f);
+        rawSignalBuffer.assign(static_cast<size_t>(maxBlockSize), 0.0f);
+        noiseBuffer.assign(static_cast<size_t>(maxBlockSize), 0.0f);
+    }
+
+    void FastBlades::serialiseState(StateArchive &archive)
     {
-        float toneOut = toneComp.process();
-        float noiseOut = noiseComp.process(toneComp.getRawSignal());
-        return level * (toneOut + delayComp.process(toneComp.getRawSine(), noiseOut));
+        archive(level);
+        toneComp.serialiseState(archive);
+        noiseComp.serialiseState(archive);
+        delayComp.serialiseState(archive);
+    }
+
+    void FastBlades::processBlock(const float *speedIn, float *out, int numSamples)
+    {
+        JR_TRACE_SCOPE("FastBlades::processBlock");
+        jassert(numSamples <= static_cast<int>(noiseBuffer.size()));
+
+        toneComp.processBlock(speedIn, rawSineBuffer.data(), rawSignalBuffer.data(), out, numSamples);
+        noiseComp.processBlock(rawSignalBuffer.data(), noiseBuffer.data(), numSamples);
+        delayComp.processBlock(rawSineBuffer.data(), noiseBuffer.data(), noiseBuffer.data(), numSamples);
+
+        for (int i = 0; i < numSamples; i++)
+            out[i] = level * (out[i] + noiseBuffer[static_cast<size_t>(i)]);
     }
 
     //======================= Fan Propeller =========================//
@@ -171,10 +296,30 @@ namespace jr
         hasInit = true;
     }
 
-    void FanPropeller::setCurrentSpeed(float speedInHz)
+    void FanPropeller::setMaxBlockSize(int maxBlockSize)
+    {
+        mainBlades.setMaxBlockSize(maxBlockSize);
+        fastBlades.setMaxBlockSize(maxBlockSize);
+
+        speedBuffer.assign(static_cast<size_t>(maxBlockSize), 0.0f);
+        fastBladesBuffer.assign(static_cast<size_t>(maxBlockSize), 0.0f);
+        mainBladesBuffer.assign(static_cast<size_t>(maxBlockSize), 0.0f);
+    }
+
+    void FanPropeller::setControlInterval(int numSamples)
     {
-        mainBlades.setSpeed(speedInHz);
-        fastBlades.setSpeed(speedInHz);
+        speed.setInterval(numSamples);
+        pannerComp.setControlInterval(numSamples);
+        mainBlades.setControlInterval(numSamples);
+        fastBlades.setControlInterval(numSamples);
+    }
+
+    void FanPropeller::reset()
+    {
+        mainBlades.reset();
+        fastBlades.reset();
+        pannerComp.reset();
+        speed.reset();
     }
 
     void FanPropeller::setPulseWidth(float pw)
@@ -195,19 +340,33 @@ namespace jr
         fastBlades.setNoiseLevel(noiseLevel);
     }
 
-    void FanPropeller::process(float envelope)
+    void FanPropeller::serialiseState(StateArchive &archive)
+    {
+        archive(hasInit, speed);
+        pannerComp.serialiseState(archive);
+        mainBlades.serialiseState(archive);
+        fastBlades.serialiseState(archive);
+    }
+
+    void FanPropeller::processBlock(const float *speedIn, float *leftOut, float *rightOut, int numSamples)
     {
         if (!hasInit)
+        {
+            juce::FloatVectorOperations::clear(leftOut, numSamples);
+            juce::FloatVectorOperations::clear(rightOut, numSamples);
             return;
+        }
+
+        jassert(numSamples <= static_cast<int>(speedBuffer.size()));
 
-        float currentSpeed = maxSpeed * envelope;
-        setCurrentSpeed(currentSpeed);
+        speed.process(speedBuffer.data(), numSamples, [&](int i)
+                      { return speedIn[i]; });
 
-        float rawOut = (fastBlades.process() + mainBlades.process());
+        fastBlades.processBlock(speedBuffer.data(), fastBladesBuffer.data(), numSamples);
+        mainBlades.processBlock(speedBuffer.data(), mainBladesBuffer.data(), numSamples);
 
-        pannerComp.process(mainBlades.getPanControlSignal());
+        juce::FloatVectorOperations::add(fastBladesBuffer.data(), mainBladesBuffer.data(), numSamples);
 
-        currentLeftSample = rawOut * pannerComp.getLeft();
-        currentRightSample = rawOut * pannerComp.getRight();
+        pannerComp.processBlock(mainBlades.getPanControlSignal(), fastBladesBuffer.data(), leftOut, rightOut, numSamples);
     }
 }
@@ -0,0 +1,375 @@
+#include <PhysicalModellingFan/components/services/jr_OfflineRenderer.h>
+#include <PhysicalModellingFan/components/audio/jr_FanBank.h>
+#include <PhysicalModellingFan/utils/jr_Trace.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+namespace jr
+{
+    namespace
+    {
+        bool isNumber(const juce::String &text)
+        {
+            return text.isNotEmpty() && text.containsOnly("0123456789.-+eE") && text.containsAnyOf("0123456789");
+        }
+
+        /**
+        A scene of many fans rendered with a FanBank, controlled with the same parameters as a Machine and driven the same way: the motor envelope and the
+        smoothed speed set the speed of every fan each sample, and the mix is scaled by the smoothed gain and the envelope
+        */
+        class FanBankScene
+        {
+        public:
+            /**
+             * @param _numFans - number of fans in the scene
+             * @param pool - pool the fans are rendered across, nullptr to render them on the calling thread
+             */
+            FanBankScene(int _numFans, WorkerPool *pool) : numFans(_numFans)
+            {
+                bank.setWorkerPool(pool);
+            }
+
+            void prepare(float sampleRate, int _maxBlockSize)
+            {
+                maxBlockSize = juce::jmax(1, _maxBlockSize);
+                bank.prepare(sampleRate, maxBlockSize, numFans);
+                bank.setNumVoices(numFans);
+                envelope.setSampleRate(sampleRate);
+                gain.reset(sampleRate, gainSmoothingInS);
+                maxSpeed.reset(sampleRate, speedSmoothingInS);
+                envelopeBuffer.assign(static_cast<size_t>(maxBlockSize), 0.0f);
+                speedBuffer.assign(static_cast<size_t>(maxBlockSize), 0.0f);
+            }
+
+            void setSeed(uint64_t seed) { bank.setSeed(seed); }
+
+            /** Applies the parameters at the start of the render, nothing is smoothed from the defaults */
+            void setParameters(const MachineParameters &newParams)
+            {
+                params = newParams;
+                gain.setCurrentAndTargetValue(params.gain);
+                maxSpeed.setCurrentAndTargetValue(params.speed);
+                envelope.setPowerUpTime(params.powerUpTime);
+                envelope.setPowerDownTime(params.powerDownTime);
+                updateVoices();
+
+                if (params.powerOn)
+                    envelope.powerOn();
+            }
+
+            /** Renders a block, applying each event at its sample offset the same way as Machine::processBlock() */
+            void processBlock(float *left, float *right, int numSamples, const MachineParameterEvent *events, int numEvents)
+            {
+                int start = 0;
+
+                for (int i = 0; i < numEvents; i++)
+                {
+                    const int offset = juce::jlimit(start, numSamples, events[i].sampleOffset);
+
+                    if (offset > start)
+                    {
+                        processBlock(left + start, right + start, offset - start);
+                        start = offset;
+                    }
+
+                    setParameter(events[i].id, events[i].value);
+                }
+
+                if (start < numSamples)
+                    processBlock(left + start, right + start, numSamples - start);
+            }
+
+        private:
+            void setParameter(MachineParameterId id, float value)
+            {
+                const bool wasOn = params.powerOn;
+                params.set(id, value);
+
+                switch (id)
+                {
+                case MachineParameterId::gain:
+                    gain.setTargetValue(params.gain);
+                    break;
+                case MachineParameterId::speed:
+                    maxSpeed.setTargetValue(params.speed);
+                    break;
+                case MachineParameterId::powerUpTime:
+                    envelope.setPowerUpTime(params.powerUpTime);
+                    break;
+                case MachineParameterId::powerDownTime:
+                    envelope.setPowerDownTime(params.powerDownTime);
+                    break;
+                case MachineParameterId::powerOn:
+                    if (params.powerOn != wasOn)
+                        params.powerOn ? envelope.powerOn() : envelope.powerOff();
+                    break;
+                case MachineParameterId::toneLevel:
+                case MachineParameterId::noiseLevel:
+                case MachineParameterId::stereoWidth:
+                case MachineParameterId::dopplerOn:
+                    updateVoices();
+                    break;
+                }
+            }
+
+            /** the same as Machine::processBlock(), going idle on the sample the envelope falls to 0 */
+            void processBlock(float *left, float *right, int numSamples)
+            {
+                for (int start = 0; start < numSamples;)
+                {
+                    if (!envelope.getIsPowerOn() && envelope.getCurrentValue() <= 0.0f)
+                    {
+                        if (!bankIsReset)
+                        {
+                            bank.reset();
+                            bankIsReset = true;
+                        }
+
+                        gain.setCurrentAndTargetValue(gain.getTargetValue());
+                        maxSpeed.setCurrentAndTargetValue(maxSpeed.getTargetValue());
+
+                        juce::FloatVectorOperations::clear(left + start, numSamples - start);
+                        juce::FloatVectorOperations::clear(right + start, numSamples - start);
+                        return;
+                    }
+
+                    bankIsReset = false;
+                    start += processSubBlock(left + start, right + start, juce::jmin(maxBlockSize, numSamples - start));
+                }
+            }
+
+            /** the same as Machine::processSubBlock(), with every fan of the bank in place of the FanPropeller */
+            int processSubBlock(float *left, float *right, int maxSamples)
+            {
+                const int numSamples = envelope.processBlockUntilSilent(envelopeBuffer.data(), maxSamples);
+
+                for (int i = 0; i < numSamples; i++)
+                    speedBuffer[static_cast<size_t>(i)] = envelopeBuffer[static_cast<size_t>(i)] * maxSpeed.getNextValue();
+
+                bank.processBlock(speedBuffer.data(), left, right, numSamples);
+
+                for (int i = 0; i < numSamples; i++)
+                {
+                    const float currentGain = gain.getNextValue() * envelopeBuffer[static_cast<size_t>(i)];
+                    left[i] *= currentGain;
+                    right[i] *= currentGain;
+                }
+
+                return numSamples;
+            }
+
+            /** every fan has a speed of 1 Hz and a gain of 1, as processSubBlock() scales them by the smoothed speed and gain */
+            void updateVoices()
+            {
+                FanBank::VoiceParameters voice;
+                voice.speed = 1.0f;
+                voice.gain = 1.0f;
+                voice.toneLevel = params.toneLevel;
+                voice.noiseLevel = params.noiseLevel;
+                voice.stereoWidth = params.stereoWidth;
+                voice.dopplerOn = params.dopplerOn;
+
+                for (int fan = 0; fan < numFans; fan++)
+                    bank.setVoiceParameters(fan, voice);
+            }
+
+            static constexpr float gainSmoothingInS{0.1f};  // the same smoothing times as the Machine (seconds)
+            static constexpr float speedSmoothingInS{0.05f}; // seconds
+
+            int numFans;
+            int maxBlockSize{};
+            FanBank bank;
+            MachineEnvelope envelope;
+            MachineParameters params;
+            juce::SmoothedValue<float> gain;
+            juce::SmoothedValue<float> maxSpeed; // speed of the fans at full power (Hz)
+            std::vector<float> envelopeBuffer;   // motor envelope value for each sample of the current block
+            std::vector<float> speedBuffer;      // current speed of the fans for each sample of the current block (Hz)
+            bool bankIsReset{true};              // true while the scene is idle and the bank has been cleared
+        };
+    }
+
+    juce::Result OfflineRenderer::loadAutomation(const juce::File &file, std::vector<AutomationPoint> &points)
+    {
+        if (!file.existsAsFile())
+            return juce::Result::fail("Automation file: " + file.getFullPathName() + " does not exist");
+
+        juce::StringArray lines;
+        lines.addLines(file.loadFileAsString());
+
+        for (int i = 0; i < lines.size(); i++)
+        {
+            const auto line = lines[i].upToFirstOccurrenceOf("#", false, false).trim();
+            if (line.isEmpty())
+                continue;
+
+            const auto where = file.getFileName() + ":" + juce::String(i + 1) + ": ";
+
+            juce::StringArray tokens;
+            tokens.addTokens(line, " \t", "");
+            tokens.removeEmptyStrings();
+
+            if (tokens.size() != 3 || !isNumber(tokens[0]) || !isNumber(tokens[2]))
+                return juce::Result::fail(where + "expected <time> <parameter> <value>");
+
+            const auto id = MachineParameters::getId(tokens[1]);
+            if (!id)
+                return juce::Result::fail(where + "unknown parameter " + tokens[1]);
+
+            const double time = tokens[0].getDoubleValue();
+            if (time < 0.0)
+                return juce::Result::fail(where + "time must not be negative");
+
+            points.push_back({time, *id, tokens[2].getFloatValue()});
+        }
+
+        // changes at the same time keep their order in the script
+        std::stable_sort(points.begin(), points.end(), [](const AutomationPoint &a, const AutomationPoint &b)
+                         { return a.timeInSeconds < b.timeInSeconds; });
+
+        return juce::Result::ok();
+    }
+
+    juce::Result OfflineRenderer::render(const RenderJob &job, WorkerPool *pool)
+    {
+        JR_TRACE_SCOPE("OfflineRenderer::render");
+
+        if (job.sampleRate <= 0.0 || job.durationInS <= 0.0 || job.blockSize <= 0)
+            return juce::Result::fail(job.outputFile.getFileName() + ": sample rate, duration and block size must be greater than 0");
+
+        if (job.numFans < 0)
+            return juce::Result::fail(job.outputFile.getFileName() + ": the number of fans must not be negative");
+
+        MachineParameters params;
+        if (job.presetFile != juce::File())
+            if (const auto result = params.loadPreset(job.presetFile); result.failed())
+                return result;
+
+        std::vector<AutomationPoint> automation;
+        if (job.automationFile != juce::File())
+            if (const auto result = loadAutomation(job.automationFile, automation); result.failed())
+                return result;
+
+        std::unique_ptr<juce::AudioFormat> format;
+        if (job.outputFile.hasFileExtension("wav"))
+            format = std::make_unique<juce::WavAudioFormat>();
+        else if (job.outputFile.hasFileExtension("flac"))
+            format = std::make_unique<juce::FlacAudioFormat>();
+        else
+            return juce::Result::fail(job.outputFile.getFileName() + ": output must be a .wav or .flac file");
+
+        if (!format->getPossibleBitDepths().contains(job.bitDepth))
+            return juce::Result::fail(job.outputFile.getFileName() + ": " + juce::String(job.bitDepth) + " bit is not supported by " + format->getFormatName());
+
+        // FileOutputStream appends to an existing file
+        if (job.outputFile.existsAsFile() && !job.outputFile.deleteFile())
+            return juce::Result::fail("Could not overwrite " + job.outputFile.getFullPathName());
+
+        if (const auto result = job.outputFile.getParentDirectory().createDirectory(); result.failed())
+            return result;
+
+        auto stream = std::make_unique<juce::FileOutputStream>(job.outputFile);
+        if (stream->failedToOpen())
+            return juce::Result::fail("Could not create " + job.outputFile.getFullPathName() + ": " + stream->getStatus().getErrorMessage());
+
+        std::unique_ptr<juce::AudioFormatWriter> writer(format->createWriterFor(stream.get(), job.sampleRate, 2, job.bitDepth, {}, 0));
+        if (writer == nullptr)
+            return juce::Result::fail("Could not create a " + format->getFormatName() + " writer for " + job.outputFile.getFullPathName());
+
+        stream.release(); // the writer owns the stream now
+
+        juce::ScopedNoDenormals noDenormals;
+
+        // the Machine and the FanBankScene are rendered the same way, with the automation as events in each block
+        auto renderBlocks = [&](auto &source)
+        {
+            source.prepare(static_cast<float>(job.sampleRate), job.blockSize);
+            if (job.seed)
+                source.setSeed(*job.seed);
+
+            source.setParameters(params);
+
+            juce::AudioBuffer<float> buffer(2, job.blockSize);
+            std::vector<MachineParameterEvent> events;
+            events.reserve(automation.size());
+
+            const auto totalSamples = static_cast<juce::int64>(std::llround(job.durationInS * job.sampleRate));
+            size_t nextPoint = 0;
+
+            for (juce::int64 position = 0; position < totalSamples; position += job.blockSize)
+            {
+                JR_TRACE_SCOPE("OfflineRenderer::renderBlock");
+                const int numSamples = static_cast<int>(juce::jmin(static_cast<juce::int64>(job.blockSize), totalSamples - position));
+
+                // automation lands on the nearest sample, the same as a change scheduled on the plugin's timeline
+                events.clear();
+                while (nextPoint < automation.size())
+                {
+                    const auto &point = automation[nextPoint];
+                    const auto offset = static_cast<juce::int64>(std::llround(point.timeInSeconds * job.sampleRate)) - position;
+
+                    if (offset >= numSamples)
+                        break;
+
+                    events.push_back({static_cast<int>(juce::jmax(offset, juce::int64{0})), point.id, point.value});
+                    nextPoint++;
+                }
+
+                source.processBlock(buffer.getWritePointer(0), buffer.getWritePointer(1), numSamples, events.data(), static_cast<int>(events.size()));
+                buffer.applyGain(0, numSamples, outputGain);
+
+                if (!writer->writeFromAudioSampleBuffer(buffer, 0, numSamples))
+                    return juce::Result::fail("Could not write to " + job.outputFile.getFullPathName());
+            }
+
+            return juce::Result::ok();
+        };
+
+        if (job.numFans > 0)
+        {
+            FanBankScene scene(job.numFans, pool);
+            return renderBlocks(scene);
+        }
+
+        Machine machine;
+        return renderBlocks(machine);
+    }
+
+    std::vector<juce::Result> OfflineRenderer::renderAll(const std::vector<RenderJob> &jobs, int numThreads)
+    {
+        std::vector<juce::Result> results(jobs.size(), juce::Result::ok());
+        std::atomic<size_t> nextJob{0};
+
+        const auto numWorkers = static_cast<size_t>(juce::jlimit(1, juce::jmax(1, static_cast<int>(jobs.size())), numThreads));
+        const int threadsPerJob = juce::jmax(1, numThreads / static_cast<int>(numWorkers));
+
+        // each thread takes the next job when it finishes one, so long and short jobs even out across the threads.
+        // A thread starts its share of the threads as a pool the first time it renders a job with fans, and keeps it for the jobs after
+        auto renderJobs = [&]
+        {
+            JR_TRACE_THREAD_NAME("Render");
+            std::unique_ptr<WorkerPool> pool;
+
+            for (auto i = nextJob++; i < jobs.size(); i = nextJob++)
+            {
+                if (jobs[i].numFans > 0 && threadsPerJob > 1 && pool == nullptr)
+                    pool = std::make_unique<WorkerPool>(threadsPerJob);
+
+                results[i] = render(jobs[i], pool.get());
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (size_t i = 1; i < numWorkers; i++)
+            workers.emplace_back(renderJobs);
+
+        renderJobs();
+
+        for (auto &worker : workers)
+            worker.join();
+
+        return results;
+    }
+}
@@ -0,0 +1,228 @@
+#include <PhysicalModellingFan/components/services/jr_PresetIndex.h>
+#include <PhysicalModellingFan/utils/jr_Trace.h>
+
+namespace jr
+{
+    PresetIndex::PresetIndex(const juce::File &_directory, const juce::String &_extension, int _rescanIntervalMs)
+        : juce::Thread("Preset index"), directory(_directory), extension(_extension), rescanIntervalMs(juce::jmax(1, _rescanIntervalMs))
+    {
+    }
+
+    PresetIndex::~PresetIndex()
+    {
+        stopThread(10000);
+    }
+
+    std::vector<PresetInfo> PresetIndex::getPresets()
+    {
+        start();
+
+        const juce::ScopedLock sl(lock);
+
+        std::vector<PresetInfo> result;
+        result.reserve(presets.size());
+        for (const auto &[name, info] : presets)
+            result.push_back(info);
+
+        return result;
+    }
+
+    juce::StringArray PresetIndex::getPresetNames()
+    {
+        start();
+
+        const juce::ScopedLock sl(lock);
+
+        juce::StringArray names;
+        for (const auto &[name, info] : presets)
+            names.add(name);
+
+        return names;
+    }
+
+    std::optional<PresetInfo> PresetIndex::getPreset(const juce::String &name)
+    {
+        start();
+
+        const juce::ScopedLock sl(lock);
+
+        if (const auto found = presets.find(name); found != presets.end())
+            return found->second;
+
+        return std::nullopt;
+    }
+
+    void PresetIndex::fileChanged(const juce::File &file)
+    {
+        {
+            const juce::ScopedLock sl(lock);
+            pendingChanges.emplace_back(file, true);
+        }
+
+        start();
+        notify();
+    }
+
+    void PresetIndex::fileDeleted(const juce::File &file)
+    {
+        {
+            const juce::ScopedLock sl(lock);
+            pendingChanges.emplace_back(file, false);
+        }
+
+        start();
+        notify();
+    }
+
+    void PresetIndex::rescan()
+    {
+        rescanRequested = true;
+
+        start();
+        notify();
+    }
+
+    void PresetIndex::addWatchingListener(juce::ChangeListener *listener)
+    {
+        addChangeListener(listener);
+        numWatchers++;
+
+        rescan();
+    }
+
+    void PresetIndex::removeWatchingListener(juce::ChangeListener *listener)
+    {
+        removeChangeListener(listener);
+        numWatchers--;
+    }
+
+    //================= private methods =====================
+
+    void PresetIndex::start()
+    {
+        if (!isThreadRunning())
+            startThread(juce::Thread::Priority::background);
+    }
+
+    void PresetIndex::run()
+    {
+        JR_TRACE_THREAD_NAME("Preset index");
+
+        if (!directory.exists())
+        {
+            const auto result = directory.createDirectory();
+            if (result.failed())
+            {
+                DBG("Could not create preset directory: " + result.getErrorMessage());
+                jassertfalse;
+            }
+        }
+
+        auto nextScanTime = juce::Time::getMillisecondCounter();
+
+        // time left until the next full scan, the difference is signed so it still works when the counter wraps around
+        auto getTimeToNextScan = [&]
+        { return static_cast<int>(nextScanTime - juce::Time::getMillisecondCounter()); };
+
+        while (!threadShouldExit())
+        {
+            bool hasChanged = applyPendingChanges();
+
+            // the directory may be on a network drive shared by many instances, so it is only polled while something shows the presets
+            const bool isWatched = numWatchers.load() > 0;
+
+            if (rescanRequested.exchange(false) || (isWatched && getTimeToNextScan() <= 0))
+            {
+                if (!scanDirectory())
+                    return;
+
+                hasChanged = true;
+                hasScanned = true;
+                nextScanTime = juce::Time::getMillisecondCounter() + static_cast<juce::uint32>(rescanIntervalMs);
+            }
+
+            if (hasChanged)
+                sendChangeMessage();
+
+            // woken early by fileChanged(), fileDeleted(), rescan() and a new watching listener. A watcher that is removed is noticed at the next wake up
+            wait(numWatchers.load() > 0 ? juce::jmax(0, getTimeToNextScan()) : -1);
+        }
+    }
+
+    bool PresetIndex::scanDirectory()
+    {
+        JR_TRACE_SCOPE("PresetIndex::scanDirectory");
+
+        std::map<juce::String, PresetInfo> previous;
+        {
+            const juce::ScopedLock sl(lock);
+            previous = presets;
+        }
+
+        // only this thread writes the index, so files that have not changed can be copied over without reading them again
+        std::map<juce::String, PresetInfo> scanned;
+
+        for (const auto &entry : juce::RangedDirectoryIterator(directory, false, "*." + extension, juce::File::findFiles))
+        {
+            if (threadShouldExit())
+                return false;
+
+            const auto &file = entry.getFile();
+            const auto name = file.getFileNameWithoutExtension();
+
+            if (const auto found = previous.find(name);
+                found != previous.end() && found->second.file == file && found->second.modificationTime == entry.getModificationTime())
+            {
+                scanned.emplace(name, found->second);
+            }
+            else if (auto info = readPreset(file))
+            {
+                scanned.emplace(name, std::move(*info));
+            }
+        }
+
+        const juce::ScopedLock sl(lock);
+        presets = std::move(scanned);
+
+        return true;
+    }
+
+    bool PresetIndex::applyPendingChanges()
+    {
+        std::vector<std::pair<juce::File, bool>> changes;
+        {
+            const juce::ScopedLock sl(lock);
+            std::swap(changes, pendingChanges);
+        }
+
+        for (const auto &[file, exists] : changes)
+        {
+            // the file is read before taking the lock, so readers never wait on the file system
+            const auto info = exists ? readPreset(file) : std::nullopt;
+
+            const juce::ScopedLock sl(lock);
+            if (info)
+                presets.insert_or_assign(info->name, *info);
+            else
+                presets.erase(file.getFileNameWithoutExtension());
+        }
+
+        return !changes.empty();
+    }
+
+    std::optional<PresetInfo> PresetIndex::readPreset(const juce::File &file) const
+    {
+        PresetInfo info;
+        info.name = file.getFileNameWithoutExtension();
+        info.file = file;
+        info.modificationTime = file.getLastModificationTime();
+
+        if (const auto result = info.parameters.loadPreset(file); result.failed())
+        {
+            DBG(result.getErrorMessage());
+            return std::nullopt;
+        }
+
+        return info;
+    }
+}
@@ -0,0 +1,138 @@
+#include <PhysicalModellingFan/components/services/jr_PresetLoader.h>
+#include <PhysicalModellingFan/utils/jr_Trace.h>
+
+namespace jr
+{
+    PresetLoader::PresetLoader(juce::AudioProcessorValueTreeState &_apvts) : juce::Thread("Preset loader"), apvts(_apvts), stateType(_apvts.state.getType())
+    {
+    }
+
+    PresetLoader::~PresetLoader()
+    {
+        stopThread(10000);
+        cancelPendingUpdate();
+    }
+
+    void PresetLoader::load(const juce::File &file, const juce::String &presetName)
+    {
+        {
+            const juce::ScopedLock sl(lock);
+            request = std::make_pair(file, presetName);
+        }
+
+        if (!isThreadRunning())
+            startThread();
+
+        notify();
+    }
+
+    bool PresetLoader::getPresetParameters(MachineParameters &params, bool &isNewPreset)
+    {
+        isNewPreset = snapshots.read(snapshotInFlight);
+        if (isNewPreset)
+            hasSnapshotInFlight = true;
+
+        // once the preset is in the apvts the host parameters hold all of it, and any automation since
+        if (hasSnapshotInFlight && appliedGeneration.load(std::memory_order_acquire) >= snapshotInFlight.generation)
+            hasSnapshotInFlight = false;
+
+        if (!hasSnapshotInFlight)
+            return false;
+
+        params = snapshotInFlight.parameters;
+        return true;
+    }
+
+    //================= private methods =====================
+
+    void PresetLoader::run()
+    {
+        JR_TRACE_THREAD_NAME("Preset loader");
+
+        while (!threadShouldExit())
+        {
+            std::optional<std::pair<juce::File, juce::String>> next;
+            {
+                const juce::ScopedLock sl(lock);
+                std::swap(next, request);
+            }
+
+            if (!next)
+            {
+                wait(-1);
+                continue;
+            }
+
+            JR_TRACE_SCOPE("PresetLoader::readPreset");
+
+            LoadedPreset preset;
+            Snapshot snapshot;
+
+            if (const auto result = readPreset(next->first, preset.state, snapshot.parameters); result.failed())
+            {
+                DBG(result.getErrorMessage());
+                jassertfalse;
+                continue;
+            }
+
+            preset.presetName = next->second;
+            preset.generation = snapshot.generation = ++lastGeneration;
+
+            // the audio thread gets the snapshot first, so it never sees the apvts part way through changing without it
+            snapshots.write(snapshot);
+
+            {
+                const juce::ScopedLock sl(lock);
+                loaded = std::move(preset);
+            }
+
+            triggerAsyncUpdate();
+        }
+    }
+
+    void PresetLoader::handleAsyncUpdate()
+    {
+        std::optional<LoadedPreset> preset;
+        {
+            const juce::ScopedLock sl(lock);
+            std::swap(preset, loaded);
+        }
+
+        if (!preset)
+            return;
+
+        {
+            JR_TRACE_SCOPE("replaceState");
+            apvts.replaceState(preset->state);
+        }
+
+        appliedGeneration.store(preset->generation, std::memory_order_release);
+
+        if (onPresetLoaded)
+            onPresetLoaded(preset->presetName);
+    }
+
+    juce::Result PresetLoader::readPreset(const juce::File &file, juce::ValueTree &state, MachineParameters &params) const
+    {
+        if (!file.existsAsFile())
+            return juce::Result::fail("Preset file: " + file.getFullPathName() + " does not exist");
+
+        const auto xml = juce::parseXML(file);
+        if (xml == nullptr || !xml->hasTagName(stateType.toString()))
+            return juce::Result::fail("Preset file: " + file.getFullPathName() + " is not a preset for this plugin");
+
+        state = juce::ValueTree::fromXml(*xml);
+        if (!state.isValid())
+            return juce::Result::fail("Preset file: " + file.getFullPathName() + " could not be read");
+
+        // replaceState() sets parameters missing from the preset to their defaults, so the snapshot starts from the defaults too
+        for (auto *parameter : apvts.processor.getParameters())
+            if (const auto *ranged = dynamic_cast<juce::RangedAudioParameter *>(parameter))
+                if (const auto id = MachineParameters::getId(ranged->getParameterID()))
+                    params.set(*id, ranged->convertFrom0to1(ranged->getDefaultValue()));
+
+        params.readPreset(*xml);
+
+        return juce::Result::ok();
+    }
+}
@@ -1,4 +1,5 @@
 #include <PhysicalModellingFan/components/services/jr_PresetManager.h>
+#include <PhysicalModellingFan/utils/jr_Trace.h>
 
 namespace jr
 {
@@ -10,20 +11,14 @@ namespace jr
     const juce::String PresetManager::extension{"preset"};
     const juce::String PresetManager::presetNameProperty{"presetName"};
 
-    PresetManager::PresetManager(juce::AudioProcessorValueTreeState &_apvts) : apvts(_apvts)
+    PresetManager::PresetManager(juce::AudioProcessorValueTreeState &_apvts, PresetLoader &_presetLoader) : apvts(_apvts), presetLoader(_presetLoader)
     {
-        if (!defaultDirectory.exists())
-        {
-            const auto result = defaultDirectory.createDirectory();
-            if (result.failed())
-            {
-                DBG("Could not create preset directory: " + result.getErrorMessage());
-                jassertfalse;
-            }
-        }
-
+        // the preset directory is created by the index on its background thread, as it may be on a slow network drive
         apvts.state.addListener(this);
         currentPreset.referTo(apvts.state.getPropertyAsValue(presetNameProperty, nullptr));
+
+        presetLoader.onPresetLoaded = [this](const juce::String &presetName)
+        { currentPreset.setValue(presetName); };
     }
 
     void PresetManager::savePreset(const juce::String &presetName)
@@ -34,11 +29,13 @@ namespace jr
         currentPreset.setValue(presetName);
         const auto xmlState = apvts.copyState().createXml();
         const auto presetFile = getPresetFile(presetName);
-        if (!xmlState->writeTo(presetFile))
+        if (presetFile.getParentDirectory().createDirectory().failed() || !xmlState->writeTo(presetFile))
         {
             DBG("Could not create preset file: " + presetFile.getFullPathName());
             jassertfalse;
+            return;
         }
+        presetIndex->fileChanged(presetFile);
     }
 
     void PresetManager::deletePreset(const juce::String &presetName)
@@ -60,38 +57,20 @@ namespace jr
             jassertfalse;
             return;
         }
+        presetIndex->fileDeleted(presetFile);
         currentPreset.setValue("");
     }
 
     void PresetManager::loadPreset(const juce::String &presetName)
     {
-        if (presetName.isEmpty())
-            return;
+        JR_TRACE_THREAD_NAME("Message"); // presets are loaded from the preset panel
+        JR_TRACE_SCOPE("PresetManager::loadPreset");
 
-        const auto presetFile = getPresetFile(presetName);
-        if (!presetFile.existsAsFile())
-        {
-            DBG("Preset file: " + presetFile.getFullPathName() + " does not exist");
-            jassertfalse;
+        if (presetName.isEmpty())
             return;
-        }
-
-        juce::XmlDocument xmlDocument{presetFile};
-        const auto valueTreeToLoad = juce::ValueTree::fromXml(*xmlDocument.getDocumentElement());
-        apvts.replaceState(valueTreeToLoad);
-        currentPreset.setValue(presetName);
-    }
 
-    juce::StringArray PresetManager::getAllPresets()
-    {
-        const auto fileArray = defaultDirectory.findChildFiles(
-            juce::File::TypesOfFileToFind::findFiles, false, "*." + extension);
-        juce::StringArray presets;
-        for (const auto &file : fileArray)
-        {
-            presets.add(file.getFileNameWithoutExtension());
-        }
-        return presets;
+        // the file is read and checked on the loader's thread, so a slow drive never holds up the editor
+        presetLoader.load(getPresetFile(presetName), presetName);
     }
 
     //================= private methods =====================
@@ -0,0 +1,165 @@
+#include <PhysicalModellingFan/components/services/jr_StateCodec.h>
+#include <cstring>
+
+namespace jr
+{
+    namespace
+    {
+        constexpr std::array<char, 4> magic{'J', 'R', 'F', 'S'};
+        constexpr size_t headerSize{magic.size() + 2 + 2}; // magic, version, number of parameters
+
+        /** Writes bytes one after another into a block that has already been sized for them */
+        struct Writer
+        {
+            juce::uint8 *pos;
+
+            void write(const void *data, size_t size)
+            {
+                std::memcpy(pos, data, size);
+                pos += size;
+            }
+
+            void writeUint8(juce::uint8 value) { *pos++ = value; }
+
+            void writeUint16(juce::uint16 value)
+            {
+                writeUint8(static_cast<juce::uint8>(value & 0xff));
+                writeUint8(static_cast<juce::uint8>(value >> 8));
+            }
+
+            void writeFloat(float value)
+            {
+                juce::uint32 bits;
+                std::memcpy(&bits, &value, sizeof(bits));
+                bits = juce::ByteOrder::swapIfBigEndian(bits);
+                write(&bits, sizeof(bits));
+            }
+        };
+
+        /** Reads bytes one after another, each read fails rather than running off the end of the data */
+        struct Reader
+        {
+            const juce::uint8 *pos;
+            const juce::uint8 *end;
+
+            bool canRead(size_t size) const { return static_cast<size_t>(end - pos) >= size; }
+
+            bool readUint8(juce::uint8 &value)
+            {
+                if (!canRead(1))
+                    return false;
+
+                value = *pos++;
+                return true;
+            }
+
+            bool readUint16(juce::uint16 &value)
+            {
+                if (!canRead(2))
+                    return false;
+
+                value = juce::ByteOrder::littleEndianShort(pos);
+                pos += 2;
+                return true;
+            }
+
+            bool readFloat(float &value)
+            {
+                if (!canRead(4))
+                    return false;
+
+                const auto bits = juce::ByteOrder::littleEndianInt(pos);
+                std::memcpy(&value, &bits, sizeof(value));
+                pos += 4;
+                return true;
+            }
+
+            bool readString(size_t length, std::string_view &value)
+            {
+                if (!canRead(length))
+                    return false;
+
+                value = std::string_view(reinterpret_cast<const char *>(pos), length);
+                pos += length;
+                return true;
+            }
+        };
+    }
+
+    void StateCodec::encode(juce::MemoryBlock &dest, std::span<const Parameter> parameters, std::string_view presetName)
+    {
+        jassert(parameters.size() <= static_cast<size_t>(maxParameters));
+        jassert(presetName.size() <= maxPresetNameLength);
+
+        const auto numParameters = juce::jmin(parameters.size(), static_cast<size_t>(maxParameters));
+        presetName = presetName.substr(0, maxPresetNameLength);
+
+        size_t size = headerSize + 2 + presetName.size();
+        for (size_t i = 0; i < numParameters; i++)
+        {
+            jassert(parameters[i].id.size() <= maxIdLength);
+            size += 1 + juce::jmin(parameters[i].id.size(), maxIdLength) + 4;
+        }
+
+        dest.setSize(size);
+        Writer writer{static_cast<juce::uint8 *>(dest.getData())};
+
+        writer.write(magic.data(), magic.size());
+        writer.writeUint16(currentVersion);
+        writer.writeUint16(static_cast<juce::uint16>(numParameters));
+
+        for (size_t i = 0; i < numParameters; i++)
+        {
+            const auto id = parameters[i].id.substr(0, maxIdLength);
+            writer.writeUint8(static_cast<juce::uint8>(id.size()));
+            writer.write(id.data(), id.size());
+            writer.writeFloat(parameters[i].value);
+        }
+
+        writer.writeUint16(static_cast<juce::uint16>(presetName.size()));
+        writer.write(presetName.data(), presetName.size());
+
+        jassert(writer.pos == static_cast<juce::uint8 *>(dest.getData()) + size);
+    }
+
+    bool StateCodec::isBinaryState(const void *data, size_t sizeInBytes)
+    {
+        return data != nullptr && sizeInBytes >= magic.size() && std::memcmp(data, magic.data(), magic.size()) == 0;
+    }
+
+    juce::Result StateCodec::decode(const void *data, size_t sizeInBytes, State &state)
+    {
+        if (!isBinaryState(data, sizeInBytes))
+            return juce::Result::fail("Not a binary plugin state");
+
+        const auto *bytes = static_cast<const juce::uint8 *>(data);
+        Reader reader{bytes + magic.size(), bytes + sizeInBytes};
+
+        juce::uint16 version{}, numParameters{};
+        if (!reader.readUint16(version) || !reader.readUint16(numParameters))
+            return juce::Result::fail("Plugin state is too short");
+
+        if (version == 0 || version > currentVersion)
+            return juce::Result::fail("Plugin state version " + juce::String(version) + " is not supported");
+
+        if (numParameters > maxParameters)
+            return juce::Result::fail("Plugin state has too many parameters");
+
+        for (int i = 0; i < numParameters; i++)
+        {
+            auto &parameter = state.parameters[static_cast<size_t>(i)];
+            juce::uint8 idLength{};
+
+            if (!reader.readUint8(idLength) || !reader.readString(idLength, parameter.id) || !reader.readFloat(parameter.value))
+                return juce::Result::fail("Plugin state is damaged");
+        }
+
+        juce::uint16 presetNameLength{};
+        if (!reader.readUint16(presetNameLength) || !reader.readString(presetNameLength, state.presetName))
+            return juce::Result::fail("Plugin state is damaged");
+
+        state.numParameters = numParameters;
+
+        return juce::Result::ok();
+    }
+}
@@ -0,0 +1,213 @@
+/*
+  ==============================================================================
+
+    FanRenderMain.cpp
+
+    Command line tool that renders the fan offline, for batches of assets
+
+  ==============================================================================
+*/
+
+#include <PhysicalModellingFan/components/services/jr_OfflineRenderer.h>
+#include <PhysicalModellingFan/utils/jr_Trace.h>
+#include <juce_core/juce_core.h>
+#include <iostream>
+
+namespace
+{
+    const char *usage = R"(Renders the fan to audio files without a host, as fast as the CPU allows.
+
+Usage:
+  FanRender --out=<file> [options]
+  FanRender --jobs=<file> [options]
+
+Options:
+  --out=<file>           output file, .wav or .flac
+  --preset=<file>        preset saved by the plugin, the plugin defaults are used otherwise
+  --automation=<file>    automation script, one "<time (s)> <parameter ID> <value>" per line, # starts a comment
+  --sample-rate=<Hz>     sample rate (default 48000)
+  --duration=<s>         length of the render (default 10)
+  --block-size=<n>       samples per processing block (default 512)
+  --bits=<n>             bit depth, 16 or 24, or 32 bit float for .wav (default 24)
+  --seed=<n>             seed for the noise generators, random otherwise
+  --fans=<n>             renders a scene of n fans instead of one, each following the preset and automation
+                         with its speed spread around SPEED (default 0, one fan)
+  --jobs=<file>          renders one job per line of the file, each line holds the options above for that job
+                         and overrides the ones given on the command line, relative paths are relative to the file
+  --threads=<n>          number of jobs to render at once, threads left over when there are fewer jobs
+                         render the fans of --fans jobs (default: number of CPU cores)
+  --trace=<file>         writes a Chrome trace of the render to a .json file, needs a build with JR_ENABLE_TRACING
+)";
+
+    const juce::StringArray jobOptions{"--out", "--preset", "--automation", "--sample-rate", "--duration", "--block-size", "--bits", "--seed", "--fans"};
+
+    /** Reads the options for a job, options that are not given keep the values already in the job */
+    juce::Result parseJob(const juce::ArgumentList &args, const juce::StringArray &allowedOptions, const juce::File &baseDirectory, jr::RenderJob &job)
+    {
+        for (const auto &arg : args.arguments)
+        {
+            const auto option = arg.text.upToFirstOccurrenceOf("=", false, false);
+
+            if (!arg.isLongOption() || !allowedOptions.contains(option))
+                return juce::Result::fail("Unexpected argument: " + arg.text);
+
+            if (arg.getLongOptionValue().isEmpty())
+                return juce::Result::fail("Missing value for " + option + ", use " + option + "=<value>");
+        }
+
+        auto value = [&](const char *option)
+        { return args.getValueForOption(option).unquoted(); };
+
+        if (args.containsOption("--out"))
+            job.outputFile = baseDirectory.getChildFile(value("--out"));
+        if (args.containsOption("--preset"))
+            job.presetFile = baseDirectory.getChildFile(value("--preset"));
+        if (args.containsOption("--automation"))
+            job.automationFile = baseDirectory.getChildFile(value("--automation"));
+        if (args.containsOption("--sample-rate"))
+            job.sampleRate = value("--sample-rate").getDoubleValue();
+        if (args.containsOption("--duration"))
+            job.durationInS = value("--duration").getDoubleValue();
+        if (args.containsOption("--block-size"))
+            job.blockSize = value("--block-size").getIntValue();
+        if (args.containsOption("--bits"))
+            job.bitDepth = value("--bits").getIntValue();
+        if (args.containsOption("--seed"))
+            job.seed = static_cast<uint64_t>(value("--seed").getLargeIntValue());
+        if (args.containsOption("--fans"))
+            job.numFans = value("--fans").getIntValue();
+
+        return juce::Result::ok();
+    }
+
+    juce::Result readJobsFile(const juce::File &file, const jr::RenderJob &defaults, std::vector<jr::RenderJob> &jobs)
+    {
+        if (!file.existsAsFile())
+            return juce::Result::fail("Jobs file: " + file.getFullPathName() + " does not exist");
+
+        juce::StringArray lines;
+        lines.addLines(file.loadFileAsString());
+
+        for (int i = 0; i < lines.size(); i++)
+        {
+            const auto line = lines[i].trim();
+            if (line.isEmpty() || line.startsWithChar('#'))
+                continue;
+
+            juce::StringArray tokens;
+            tokens.addTokens(line, true);
+            tokens.removeEmptyStrings();
+
+            auto job = defaults;
+            const auto result = parseJob(juce::ArgumentList("FanRender", tokens), jobOptions, file.getParentDirectory(), job);
+            if (result.failed())
+                return juce::Result::fail(file.getFileName() + ":" + juce::String(i + 1) + ": " + result.getErrorMessage());
+
+            jobs.push_back(job);
+        }
+
+        return juce::Result::ok();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const juce::ArgumentList args(argc, argv);
+
+    if (args.size() == 0 || args.containsOption("--help|-h"))
+    {
+        std::cout << usage;
+        return 0;
+    }
+
+    auto allowedOptions = jobOptions;
+    allowedOptions.add("--jobs");
+    allowedOptions.add("--threads");
+    allowedOptions.add("--trace");
+
+    const auto workingDirectory = juce::File::getCurrentWorkingDirectory();
+
+    jr::RenderJob defaults;
+    if (const auto result = parseJob(args, allowedOptions, workingDirectory, defaults); result.failed())
+    {
+        std::cerr << result.getErrorMessage() << "\n\n"
+                  << usage;
+        return 1;
+    }
+
+#if !JR_ENABLE_TRACING
+    if (args.containsOption("--trace"))
+    {
+        std::cerr << "--trace needs a build with JR_ENABLE_TRACING, configure with -DJR_ENABLE_TRACING=ON\n";
+        return 1;
+    }
+#endif
+
+    std::vector<jr::RenderJob> jobs;
+
+    if (args.containsOption("--jobs"))
+    {
+        const auto jobsFile = workingDirectory.getChildFile(args.getValueForOption("--jobs").unquoted());
+        if (const auto result = readJobsFile(jobsFile, defaults, jobs); result.failed())
+        {
+            std::cerr << result.getErrorMessage() << "\n";
+            return 1;
+        }
+    }
+    else
+    {
+        jobs.push_back(defaults);
+    }
+
+    for (const auto &job : jobs)
+    {
+        if (job.outputFile == juce::File())
+        {
+            std::cerr << "Every job needs an output file, use --out=<file>\n";
+            return 1;
+        }
+    }
+
+    const int numThreads = args.containsOption("--threads") ? args.getValueForOption("--threads").getIntValue()
+                                                            : juce::SystemStats::getNumCpus();
+
+    const auto startTime = juce::Time::getMillisecondCounterHiRes();
+    const auto results = jr::OfflineRenderer::renderAll(jobs, numThreads);
+    const auto elapsedInS = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+
+    int numFailed = 0;
+    double renderedInS = 0.0;
+
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        if (results[i].failed())
+        {
+            std::cerr << results[i].getErrorMessage() << "\n";
+            numFailed++;
+        }
+        else
+        {
+            renderedInS += jobs[i].durationInS;
+        }
+    }
+
+    std::cout << "Rendered " << (jobs.size() - static_cast<size_t>(numFailed)) << " of " << jobs.size() << " files, "
+              << renderedInS << " s of audio in " << elapsedInS << " s ("
+              << juce::String(renderedInS / juce::jmax(elapsedInS, 1.0e-6), 1) << "x real time)\n";
+
+#if JR_ENABLE_TRACING
+    if (args.containsOption("--trace"))
+    {
+        const auto traceFile = workingDirectory.getChildFile(args.getValueForOption("--trace").unquoted());
+        if (const auto result = jr::Trace::writeJson(traceFile); result.failed())
+        {
+            std::cerr << result.getErrorMessage() << "\n";
+            return 1;
+        }
+
+        std::cout << "Trace of " << jr::Trace::getNumEvents() << " events written to " << traceFile.getFullPathName() << "\n";
+    }
+#endif
+
+    return numFailed == 0 ? 0 : 1;
+}
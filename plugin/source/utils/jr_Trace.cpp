@@ -0,0 +1,204 @@
+/*
+  ==============================================================================
+
+    jr_Trace.cpp
+
+  ==============================================================================
+*/
+
+#include <PhysicalModellingFan/utils/jr_Trace.h>
+#include <vector>
+
+namespace jr
+{
+    namespace
+    {
+        /** One event, the fields are atomic so a slot can be overwritten while toJson() reads it, which toJson() then detects and skips */
+        struct TraceEvent
+        {
+            std::atomic<const char *> name{};
+            std::atomic<juce::int64> startTicks{};
+            std::atomic<juce::int64> endTicks{};
+        };
+
+        /** Ring of events recorded by one thread, only that thread writes to it and each event is published by the release store of numRecorded */
+        struct ThreadBuffer
+        {
+            std::unique_ptr<TraceEvent[]> events{new TraceEvent[Trace::eventsPerThread]};
+            std::atomic<juce::int64> numRecorded{}; // events ever recorded, the ring holds the last eventsPerThread of them
+            std::atomic<bool> isTaken{};            // false while the buffer is reserved and no thread has recorded into it
+            std::atomic<const char *> name{};
+            std::atomic<int> threadNumber{};
+            ThreadBuffer *next{};
+        };
+
+        // buffers are pushed onto a lock free list and never freed, as threads may record until the process exits
+        std::atomic<ThreadBuffer *> firstBuffer{};
+        std::atomic<int> numThreads{};
+
+        const juce::int64 originTicks{juce::Time::getHighResolutionTicks()}; // time 0 in the trace
+
+        constexpr juce::int64 ringMask{Trace::eventsPerThread - 1};
+
+        void pushBuffer(ThreadBuffer *buffer)
+        {
+            buffer->next = firstBuffer.load(std::memory_order_relaxed);
+
+            while (!firstBuffer.compare_exchange_weak(buffer->next, buffer, std::memory_order_release, std::memory_order_relaxed))
+            {
+            }
+        }
+
+        ThreadBuffer &getThreadBuffer()
+        {
+            thread_local ThreadBuffer *buffer = nullptr;
+
+            if (buffer == nullptr)
+            {
+                // take a reserved buffer if there is one, so the first event on the audio thread does not allocate
+                for (auto *reserved = firstBuffer.load(std::memory_order_acquire); reserved != nullptr && buffer == nullptr; reserved = reserved->next)
+                {
+                    bool isTaken = false;
+                    if (reserved->isTaken.compare_exchange_strong(isTaken, true))
+                        buffer = reserved;
+                }
+
+                if (buffer == nullptr)
+                {
+                    buffer = new ThreadBuffer();
+                    buffer->isTaken.store(true, std::memory_order_relaxed);
+                    pushBuffer(buffer);
+                }
+
+                buffer->threadNumber.store(++numThreads, std::memory_order_relaxed);
+            }
+
+            return *buffer;
+        }
+
+        double ticksToMicroseconds(juce::int64 ticks)
+        {
+            return juce::Time::highResolutionTicksToSeconds(ticks - originTicks) * 1.0e6;
+        }
+    }
+
+    void Trace::record(const char *name, juce::int64 startTicks, juce::int64 endTicks)
+    {
+        auto &buffer = getThreadBuffer();
+        const auto index = buffer.numRecorded.load(std::memory_order_relaxed);
+        auto &event = buffer.events[static_cast<size_t>(index & ringMask)];
+
+        // a reader that sees any of the new fields also sees the count from before them, so it knows the slot may have been overwritten
+        std::atomic_thread_fence(std::memory_order_release);
+
+        event.name.store(name, std::memory_order_relaxed);
+        event.startTicks.store(startTicks, std::memory_order_relaxed);
+        event.endTicks.store(endTicks, std::memory_order_relaxed);
+
+        buffer.numRecorded.store(index + 1, std::memory_order_release);
+    }
+
+    void Trace::setThreadName(const char *name)
+    {
+        getThreadBuffer().name.store(name, std::memory_order_relaxed);
+    }
+
+    void Trace::reserveThreadBuffers(int numBuffers)
+    {
+        for (auto *buffer = firstBuffer.load(std::memory_order_acquire); buffer != nullptr; buffer = buffer->next)
+            if (!buffer->isTaken.load())
+                numBuffers--;
+
+        for (; numBuffers > 0; numBuffers--)
+            pushBuffer(new ThreadBuffer());
+    }
+
+    juce::int64 Trace::getNumEvents()
+    {
+        juce::int64 total = 0;
+        for (auto *buffer = firstBuffer.load(std::memory_order_acquire); buffer != nullptr; buffer = buffer->next)
+            total += buffer->numRecorded.load(std::memory_order_acquire);
+
+        return total;
+    }
+
+    juce::int64 Trace::getNumOverwrittenEvents()
+    {
+        juce::int64 total = 0;
+        for (auto *buffer = firstBuffer.load(std::memory_order_acquire); buffer != nullptr; buffer = buffer->next)
+            total += juce::jmax(juce::int64{0}, buffer->numRecorded.load(std::memory_order_acquire) - eventsPerThread);
+
+        return total;
+    }
+
+    juce::String Trace::toJson()
+    {
+        juce::MemoryOutputStream json;
+        json << "{\"traceEvents\":[";
+
+        bool isFirst = true;
+        auto addEvent = [&](const juce::String &event)
+        {
+            json << (isFirst ? "\n" : ",\n") << event;
+            isFirst = false;
+        };
+
+        for (auto *buffer = firstBuffer.load(std::memory_order_acquire); buffer != nullptr; buffer = buffer->next)
+        {
+            // reserved buffers that no thread has taken yet
+            if (!buffer->isTaken.load())
+                continue;
+
+            const auto tid = juce::String(buffer->threadNumber.load(std::memory_order_relaxed));
+
+            if (const auto *name = buffer->name.load(std::memory_order_relaxed))
+                addEvent("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + tid + ",\"args\":{\"name\":\"" + juce::JSON::escapeString(name) + "\"}}");
+
+            struct EventCopy
+            {
+                const char *name;
+                juce::int64 startTicks, endTicks;
+            };
+
+            // the events are copied out first, then any the thread may have overwritten during the copy are skipped
+            const auto numRecorded = buffer->numRecorded.load(std::memory_order_acquire);
+            const auto first = juce::jmax(juce::int64{0}, numRecorded - eventsPerThread);
+
+            std::vector<EventCopy> copies;
+            copies.reserve(static_cast<size_t>(numRecorded - first));
+
+            for (auto i = first; i < numRecorded; i++)
+            {
+                const auto &event = buffer->events[static_cast<size_t>(i & ringMask)];
+                copies.push_back({event.name.load(std::memory_order_relaxed), event.startTicks.load(std::memory_order_relaxed), event.endTicks.load(std::memory_order_relaxed)});
+            }
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            // the event after the last one published may be half written over the slot of the oldest one still valid
+            const auto firstValid = juce::jmax(first, buffer->numRecorded.load(std::memory_order_relaxed) + 1 - eventsPerThread);
+
+            for (auto i = firstValid; i < numRecorded; i++)
+            {
+                const auto &event = copies[static_cast<size_t>(i - first)];
+                const auto start = ticksToMicroseconds(event.startTicks);
+
+                // complete events, with a start time and a duration in microseconds
+                addEvent("{\"name\":\"" + juce::JSON::escapeString(event.name) + "\",\"cat\":\"jr\",\"ph\":\"X\",\"pid\":1,\"tid\":" + tid +
+                         ",\"ts\":" + juce::String(start, 3) + ",\"dur\":" + juce::String(ticksToMicroseconds(event.endTicks) - start, 3) + "}");
+            }
+        }
+
+        json << "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"overwrittenEvents\":" << getNumOverwrittenEvents() << "}}\n";
+
+        return json.toString();
+    }
+
+    juce::Result Trace::writeJson(const juce::File &file)
+    {
+        if (!file.replaceWithText(toJson()))
+            return juce::Result::fail("Could not write trace file: " + file.getFullPathName());
+
+        return juce::Result::ok();
+    }
+}
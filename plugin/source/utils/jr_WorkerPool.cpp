@@ -0,0 +1,223 @@
+/*
+  ==============================================================================
+
+    jr_WorkerPool.cpp
+
+  ==============================================================================
+*/
+
+#include <PhysicalModellingFan/utils/jr_WorkerPool.h>
+#include <PhysicalModellingFan/utils/jr_Trace.h>
+
+#if JUCE_INTEL
+#include <immintrin.h>
+#endif
+
+namespace jr
+{
+    namespace
+    {
+        /** Tells the processor this is a spin loop, so it saves power and gives way to the other hyperthread on the core */
+        void spinPause()
+        {
+#if JUCE_INTEL
+            _mm_pause();
+#endif
+        }
+
+        /** Spins for a short time while the value is unchanged, then sleeps on a futex until it changes */
+        template <typename T>
+        void waitForChange(const std::atomic<T> &value, T oldValue)
+        {
+            for (int i = 0; i < WorkerPool::spinCount; i++)
+            {
+                if (value.load(std::memory_order_acquire) != oldValue)
+                    return;
+
+                spinPause();
+            }
+
+            value.wait(oldValue, std::memory_order_acquire);
+        }
+    }
+
+    WorkerPool::WorkerPool(int numThreads)
+    {
+        const int numDeques = juce::jmax(1, numThreads);
+
+        for (int i = 0; i < numDeques; i++)
+            deques.push_back(std::make_unique<Deque>());
+
+        for (int i = 1; i < numDeques; i++)
+        {
+            auto &worker = workers.emplace_back(std::make_unique<Worker>(*this, i));
+
+            // the audio thread waits on the workers, so they run at real time priority where the system allows it
+            if (!worker->startRealtimeThread(juce::Thread::RealtimeOptions{}))
+                worker->startThread(juce::Thread::Priority::highest);
+        }
+    }
+
+    WorkerPool::~WorkerPool()
+    {
+        for (auto &worker : workers)
+            worker->signalThreadShouldExit();
+
+        epoch.fetch_add(1, std::memory_order_release);
+        epoch.notify_all();
+
+        for (auto &worker : workers)
+            worker->stopThread(1000);
+    }
+
+    //================= private methods =====================
+
+    void WorkerPool::runLoop(int numItems, ItemFunction function, void *context)
+    {
+        JR_TRACE_SCOPE("WorkerPool::parallelFor");
+
+        jassert(!isRunning);
+        jassert(numItems <= getNumThreads() * maxItemsPerThread);
+
+        const int numThreads = getNumThreads();
+
+        if (numThreads == 1 || numItems <= 1 || numItems > numThreads * maxItemsPerThread)
+        {
+            for (int item = 0; item < numItems; item++)
+                function(context, item);
+
+            return;
+        }
+
+        isRunning = true;
+        jobFunction = function;
+        jobContext = context;
+
+        // each thread starts with its own contiguous range of items, and only steals once that runs out
+        for (int thread = 0; thread < numThreads; thread++)
+        {
+            const int first = thread * numItems / numThreads;
+            const int last = (thread + 1) * numItems / numThreads;
+            deques[static_cast<size_t>(thread)]->fill(first, last - first);
+        }
+
+        jobOpen.store(true);
+        epoch.fetch_add(1, std::memory_order_release);
+        epoch.notify_all();
+
+        runItems(0);
+
+        // every item has been taken, so wait for the workers still running one. A worker that wakes up after the loop has closed
+        // sees jobOpen is false and goes back to sleep without touching the deques, so they can be filled for the next loop
+        jobOpen.store(false);
+
+        for (int active = numActive.load(); active != 0; active = numActive.load())
+            waitForChange(numActive, active);
+
+        isRunning = false;
+    }
+
+    void WorkerPool::runItems(int threadIndex)
+    {
+        const int numThreads = getNumThreads();
+        int item{};
+
+        while (deques[static_cast<size_t>(threadIndex)]->pop(item))
+            jobFunction(jobContext, item);
+
+        // starting with the next thread along spreads the thieves out over the other deques
+        for (int offset = 1; offset < numThreads; offset++)
+        {
+            auto &victim = *deques[static_cast<size_t>((threadIndex + offset) % numThreads)];
+
+            while (victim.steal(item))
+                jobFunction(jobContext, item);
+        }
+    }
+
+    //================= Deque =====================
+
+    void WorkerPool::Deque::fill(int first, int count)
+    {
+        jassert(count <= maxItemsPerThread);
+
+        for (int i = 0; i < count; i++)
+            items[static_cast<size_t>(i)] = first + i;
+
+        // published to the other threads by the store to jobOpen
+        top.store(0, std::memory_order_relaxed);
+        bottom.store(count, std::memory_order_relaxed);
+    }
+
+    bool WorkerPool::Deque::pop(int &item)
+    {
+        const int b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b);
+        int t = top.load();
+
+        if (t > b)
+        {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        item = items[static_cast<size_t>(b)];
+
+        if (t < b)
+            return true;
+
+        // the last item, which a thief may be taking at the same time
+        const bool isTaken = top.compare_exchange_strong(t, t + 1);
+        bottom.store(b + 1, std::memory_order_relaxed);
+
+        return isTaken;
+    }
+
+    bool WorkerPool::Deque::steal(int &item)
+    {
+        int t = top.load();
+
+        while (t < bottom.load())
+        {
+            item = items[static_cast<size_t>(t)];
+
+            // fails and reloads t when the owner or another thief took the item first
+            if (top.compare_exchange_weak(t, t + 1))
+                return true;
+        }
+
+        return false;
+    }
+
+    //================= Worker =====================
+
+    WorkerPool::Worker::Worker(WorkerPool &_pool, int _threadIndex) : juce::Thread("Render worker " + juce::String(_threadIndex)), pool(_pool), threadIndex(_threadIndex)
+    {
+    }
+
+    void WorkerPool::Worker::run()
+    {
+        JR_TRACE_THREAD_NAME("Render worker");
+
+        // the pool starts at epoch 0, so a worker that starts up after the first loop was started still joins it
+        juce::uint32 seenEpoch{0};
+
+        while (!threadShouldExit())
+        {
+            waitForChange(pool.epoch, seenEpoch);
+            seenEpoch = pool.epoch.load(std::memory_order_acquire);
+
+            if (threadShouldExit())
+                break;
+
+            // counted as active before looking at jobOpen, so the calling thread can not close the loop without waiting for this worker
+            pool.numActive.fetch_add(1);
+
+            if (pool.jobOpen.load())
+                pool.runItems(threadIndex);
+
+            if (pool.numActive.fetch_sub(1) == 1)
+                pool.numActive.notify_all();
+        }
+    }
+}
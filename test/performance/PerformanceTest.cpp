@@ -0,0 +1,201 @@
+#include <gtest/gtest.h>
+#include <PhysicalModellingFan/PluginProcessor.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#if JUCE_INTEL
+#if JUCE_MSVC
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+namespace audio_plugin_test {
+    namespace {
+        const juce::File baselineFile{JR_PERFORMANCE_BASELINE_FILE};
+        const juce::File reportFile{JR_PERFORMANCE_REPORT_FILE};
+
+#if JUCE_DEBUG
+        constexpr const char *buildType{"Debug"};
+#else
+        constexpr const char *buildType{"Release"};
+#endif
+
+        constexpr uint64_t seed{1234};
+        constexpr int numRepeats{5}; // the fastest repeat is kept, as other processes can only ever add time
+
+        struct Scenario {
+            const char *name; // key in the baseline budgets
+            bool dopplerOn;
+            bool powerOn;
+            double warmUpInS;  // rendered before measuring starts
+            double measureInS; // rendered while measuring
+        };
+
+        const Scenario steadyState{"steady_state", false, true, 2.0, 2.0};
+        const Scenario steadyStateDoppler{"steady_state_doppler", true, true, 2.0, 2.0};
+        const Scenario powerRamp{"power_ramp", true, true, 0.0, 1.5}; // the whole default power up time
+        const Scenario idle{"idle", true, false, 0.1, 2.0};
+
+        struct ScenarioResult {
+            juce::String name;
+            double cyclesPerSample{};
+            double nsPerSample{};
+            double budget{};
+            double limit{};
+            juce::String status;
+        };
+
+        std::vector<ScenarioResult> &getResults() {
+            static std::vector<ScenarioResult> results;
+            return results;
+        }
+
+        const juce::var &getBaseline() {
+            static const juce::var baseline = juce::JSON::parse(baselineFile);
+            return baseline;
+        }
+
+        // time stamp counter cycles, these run at a fixed rate on current x86 processors, so the budgets do not depend on frequency scaling
+        uint64_t readCycleCounter() {
+#if JUCE_INTEL
+            return __rdtsc();
+#else
+            return 0;
+#endif
+        }
+
+        void setParameter(AudioPluginAudioProcessor &processor, const juce::String &id, float value) {
+            auto *param = processor.getAPVTS().getParameter(id);
+            param->setValueNotifyingHost(param->convertTo0to1(value));
+        }
+
+        ScenarioResult measure(const Scenario &scenario, double sampleRate, int blockSize) {
+            ScenarioResult result;
+            result.name = scenario.name;
+            result.cyclesPerSample = std::numeric_limits<double>::max();
+            result.nsPerSample = std::numeric_limits<double>::max();
+
+            for (int repeat = 0; repeat < numRepeats; repeat++) {
+                AudioPluginAudioProcessor processor;
+                processor.setSeed(seed);
+                processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+                processor.prepareToPlay(sampleRate, blockSize);
+
+                setParameter(processor, ID::SPEED, 8.0f);
+                setParameter(processor, ID::FAN_DOPPLER, scenario.dopplerOn ? 1.0f : 0.0f);
+                setParameter(processor, ID::POWER, scenario.powerOn ? 1.0f : 0.0f);
+
+                juce::AudioBuffer<float> buffer(2, blockSize);
+                juce::MidiBuffer midi;
+
+                auto render = [&](double seconds) {
+                    const int numBlocks = static_cast<int>(std::ceil(seconds * sampleRate / blockSize));
+                    for (int block = 0; block < numBlocks; block++)
+                        processor.processBlock(buffer, midi);
+
+                    return numBlocks * blockSize;
+                };
+
+                render(scenario.warmUpInS);
+
+                const auto startTime = std::chrono::steady_clock::now();
+                const auto startCycles = readCycleCounter();
+                const int numSamples = render(scenario.measureInS);
+                const auto cycles = static_cast<double>(readCycleCounter() - startCycles);
+                const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - startTime;
+
+                result.cyclesPerSample = std::min(result.cyclesPerSample, cycles / numSamples);
+                result.nsPerSample = std::min(result.nsPerSample, elapsed.count() / numSamples);
+
+                processor.releaseResources();
+            }
+
+            return result;
+        }
+
+        void checkScenario(const Scenario &scenario) {
+            const auto &baseline = getBaseline();
+            ASSERT_TRUE(baseline.isObject()) << "could not read " << baselineFile.getFullPathName();
+
+            const int blockSize = baseline.getProperty("blockSize", 256);
+            const auto &budget = baseline["budgets"][scenario.name];
+            const auto &blockBudget = baseline["blockBudgets"][scenario.name];
+            ASSERT_FALSE(budget.isVoid() && blockBudget.isVoid()) << "no budget for " << scenario.name << " in " << baselineFile.getFileName();
+
+            const double tolerance = baseline.getProperty("tolerance", 0.5);
+            auto result = measure(scenario, baseline.getProperty("sampleRate", 48000.0), blockSize);
+
+            // a budget per block is spread over the samples of the block, so every scenario is reported in cycles per sample
+            result.budget = budget.isVoid() ? static_cast<double>(blockBudget) / blockSize : static_cast<double>(budget);
+            result.limit = result.budget * (1.0 + tolerance);
+
+#if !JUCE_INTEL
+            result.status = "not checked";
+            getResults().push_back(result);
+            GTEST_SKIP() << "the budgets are in x86 time stamp counter cycles, " << result.nsPerSample << " ns per sample";
+#elif JUCE_DEBUG
+            result.status = "not checked";
+            getResults().push_back(result);
+            GTEST_SKIP() << "the budgets are for optimised builds, " << result.cyclesPerSample << " cycles per sample";
+#else
+            result.status = result.cyclesPerSample <= result.limit ? "passed" : "failed";
+            getResults().push_back(result);
+            EXPECT_LE(result.cyclesPerSample, result.limit)
+                << scenario.name << " costs " << result.cyclesPerSample << " cycles per sample, the budget is "
+                << result.budget << " with " << tolerance * 100.0 << "% tolerance";
+#endif
+        }
+
+        // writes every measurement to a JSON file once all the tests have run, so the numbers can be tracked over time
+        class ReportEnvironment : public ::testing::Environment {
+        public:
+            void TearDown() override {
+                juce::Array<juce::var> scenarios;
+
+                for (const auto &result : getResults()) {
+                    juce::DynamicObject::Ptr entry = new juce::DynamicObject();
+                    entry->setProperty("name", result.name);
+                    entry->setProperty("cyclesPerSample", result.cyclesPerSample);
+                    entry->setProperty("nsPerSample", result.nsPerSample);
+                    entry->setProperty("budget", result.budget);
+                    entry->setProperty("limit", result.limit);
+                    entry->setProperty("status", result.status);
+                    scenarios.add(juce::var(entry.get()));
+                }
+
+                juce::DynamicObject::Ptr report = new juce::DynamicObject();
+                report->setProperty("time", juce::Time::getCurrentTime().toISO8601(true));
+                report->setProperty("build", buildType);
+                report->setProperty("cpu", juce::SystemStats::getCpuModel());
+                report->setProperty("baseline", baselineFile.getFullPathName());
+                report->setProperty("scenarios", scenarios);
+
+                if (!reportFile.replaceWithText(juce::JSON::toString(juce::var(report.get()))))
+                    ADD_FAILURE() << "could not write " << reportFile.getFullPathName();
+            }
+        };
+
+        [[maybe_unused]] const auto *reportEnvironment = ::testing::AddGlobalTestEnvironment(new ReportEnvironment);
+    }
+
+    TEST(Performance, steady_state_is_within_budget) {
+        checkScenario(steadyState);
+    }
+
+    TEST(Performance, steady_state_with_doppler_is_within_budget) {
+        checkScenario(steadyStateDoppler);
+    }
+
+    TEST(Performance, power_ramp_is_within_budget) {
+        checkScenario(powerRamp);
+    }
+
+    TEST(Performance, idle_is_within_budget) {
+        checkScenario(idle);
+    }
+}
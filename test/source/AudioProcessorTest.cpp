@@ -2,8 +2,97 @@
 #include <PhysicalModellingFan/PluginProcessor.h>
 
 namespace audio_plugin_test {
+    namespace {
+        void setValue(AudioPluginAudioProcessor &processor, const juce::String &id, float value) {
+            auto *parameter = processor.getAPVTS().getParameter(id);
+            parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+        }
+
+        float getValue(AudioPluginAudioProcessor &processor, const juce::String &id) {
+            return processor.getAPVTS().getRawParameterValue(id)->load();
+        }
+    }
+
     TEST(AudioPluginAudioProcessor, should_create) {
         AudioPluginAudioProcessor();
         ASSERT_TRUE(true);
     }
-}
\ No newline at end of file
+
+    TEST(AudioPluginAudioProcessor, binary_state_is_restored) {
+        AudioPluginAudioProcessor source;
+        setValue(source, ID::SPEED, 9.0f);
+        setValue(source, ID::FAN_WIDTH, 0.2f);
+        setValue(source, ID::POWER, 1.0f);
+        source.getAPVTS().state.setProperty(jr::PresetManager::presetNameProperty, "Box Fan", nullptr);
+
+        juce::MemoryBlock state;
+        source.getStateInformation(state);
+
+        AudioPluginAudioProcessor destination;
+        destination.setStateInformation(state.getData(), static_cast<int>(state.getSize()));
+
+        EXPECT_FLOAT_EQ(getValue(destination, ID::SPEED), 9.0f);
+        EXPECT_FLOAT_EQ(getValue(destination, ID::FAN_WIDTH), 0.2f);
+        EXPECT_FLOAT_EQ(getValue(destination, ID::POWER), 1.0f);
+        EXPECT_EQ(destination.getPresetManager().getCurrentPreset(), juce::String("Box Fan"));
+    }
+
+    TEST(AudioPluginAudioProcessor, legacy_xml_state_is_restored) {
+        const juce::XmlElement xml(*juce::parseXML("<PARAMETERS presetName=\"Old Fan\">\n"
+                                                   "  <PARAM id=\"SPEED\" value=\"4.0\"/>\n"
+                                                   "</PARAMETERS>\n"));
+        juce::MemoryBlock state;
+        juce::AudioProcessor::copyXmlToBinary(xml, state);
+
+        AudioPluginAudioProcessor processor;
+        processor.setStateInformation(state.getData(), static_cast<int>(state.getSize()));
+
+        EXPECT_FLOAT_EQ(getValue(processor, ID::SPEED), 4.0f);
+        EXPECT_EQ(processor.getPresetManager().getCurrentPreset(), juce::String("Old Fan"));
+    }
+
+    TEST(AudioPluginAudioProcessor, instrument_mode_plays_notes_from_midi) {
+        AudioPluginAudioProcessor processor;
+        setValue(processor, ID::INSTRUMENT_MODE, 1.0f);
+        processor.prepareToPlay(48000.0, 512);
+
+        juce::AudioBuffer<float> buffer(2, 512);
+        buffer.clear();
+        juce::MidiBuffer midi;
+        midi.addEvent(juce::MidiMessage::noteOn(1, 60, static_cast<juce::uint8>(100)), 256);
+
+        processor.processBlock(buffer, midi);
+
+        // nothing sounds until the note, even though the power parameter is off
+        EXPECT_EQ(buffer.getMagnitude(0, 0, 256), 0.0f);
+        EXPECT_GT(buffer.getMagnitude(0, 256, 256), 0.0f);
+
+        processor.releaseResources();
+    }
+
+    TEST(AudioPluginAudioProcessor, changes_scheduled_in_instrument_mode_are_kept) {
+        AudioPluginAudioProcessor processor;
+        setValue(processor, ID::INSTRUMENT_MODE, 1.0f);
+        processor.prepareToPlay(48000.0, 512);
+
+        // the power parameter stays off, only the scheduled change turns the machine on
+        ASSERT_TRUE(processor.scheduleParameterChange(100, jr::MachineParameterId::powerOn, 1.0f));
+
+        juce::AudioBuffer<float> buffer(2, 512);
+        juce::MidiBuffer midi;
+        buffer.clear();
+        processor.processBlock(buffer, midi);
+        EXPECT_EQ(buffer.getMagnitude(0, 0, 512), 0.0f);
+
+        setValue(processor, ID::INSTRUMENT_MODE, 0.0f);
+
+        for (int block = 0; block < 10; block++) {
+            buffer.clear();
+            processor.processBlock(buffer, midi);
+        }
+
+        EXPECT_GT(buffer.getMagnitude(0, 0, 512), 0.0f);
+
+        processor.releaseResources();
+    }
+}
@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+#include <PhysicalModellingFan/components/audio/jr_Machine.h>
+#include <cmath>
+#include <vector>
+
+namespace audio_plugin_test {
+    namespace {
+        // renders a fan powering up and down with doppler on, so speed, doppler cutoff, delay time and pan are all moving
+        std::vector<float> renderMachine(int controlInterval) {
+            const int numSamples = 96000;
+            const int blockSize = 480;
+
+            jr::Machine machine;
+            machine.prepare(48000.0f, blockSize);
+            machine.setSeed(7);
+            machine.setControlInterval(controlInterval);
+            machine.setSpeed(8.0f);
+            machine.setFanDoppler(true);
+            machine.setFanStereoWidth(0.8f);
+            machine.setGain(1.0f);
+            machine.setPowerUpTime(0.5f);
+            machine.setPowerDownTime(0.5f);
+            machine.togglePower(true);
+
+            std::vector<float> left(numSamples), right(numSamples), out;
+            for (int start = 0; start < numSamples; start += blockSize) {
+                if (start == numSamples / 2)
+                    machine.togglePower(false);
+
+                machine.processBlock(left.data() + start, right.data() + start, blockSize);
+            }
+
+            out.insert(out.end(), left.begin(), left.end());
+            out.insert(out.end(), right.begin(), right.end());
+            return out;
+        }
+    }
+
+    TEST(ControlRate, interpolated_control_signals_match_per_sample_reference) {
+        const auto reference = renderMachine(1);
+
+        for (int controlInterval : {8, 16, 32}) {
+            const auto interpolated = renderMachine(controlInterval);
+
+            double referencePower{}, errorPower{};
+            for (size_t i = 0; i < reference.size(); i++) {
+                const double error = interpolated[i] - reference[i];
+                referencePower += reference[i] * reference[i];
+                errorPower += error * error;
+            }
+
+            ASSERT_GT(referencePower, 0.0);
+
+            // at least 60 dB below the signal, well under audibility for a slowly moving fan
+            EXPECT_LT(10.0 * std::log10(errorPower / referencePower), -60.0) << "control interval " << controlInterval;
+        }
+    }
+}
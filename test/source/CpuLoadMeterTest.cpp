@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include <PhysicalModellingFan/components/services/jr_CpuLoadMeter.h>
+
+namespace audio_plugin_test {
+    namespace {
+        constexpr double sampleRate{48000.0};
+        constexpr int blockSize{480}; // 10 ms deadline
+
+        double secondsForLoad(double load) { return load * blockSize / sampleRate; }
+    }
+
+    TEST(CpuLoadMeter, average_settles_on_a_constant_load) {
+        jr::CpuLoadMeter meter;
+        meter.prepare(sampleRate);
+
+        for (int block = 0; block < 500; block++) // 5 s, ten time constants
+            meter.addBlock(secondsForLoad(0.3), blockSize);
+
+        EXPECT_NEAR(meter.getAverageLoad(), 0.3f, 1.0e-3f);
+        EXPECT_NEAR(meter.getPeakLoad(), 0.3f, 1.0e-6f);
+        EXPECT_EQ(meter.getNumBlocks(), 500u);
+        EXPECT_EQ(meter.getNumOverruns(), 0u);
+    }
+
+    TEST(CpuLoadMeter, histogram_counts_each_block_in_its_bin) {
+        jr::CpuLoadMeter meter;
+        meter.prepare(sampleRate);
+
+        meter.addBlock(secondsForLoad(0.05), blockSize);
+        meter.addBlock(secondsForLoad(0.45), blockSize);
+        meter.addBlock(secondsForLoad(0.45), blockSize);
+        meter.addBlock(secondsForLoad(0.95), blockSize);
+        meter.addBlock(secondsForLoad(1.5), blockSize);
+        meter.addBlock(secondsForLoad(20.0), blockSize);
+
+        EXPECT_EQ(meter.getHistogramCount(0), 1u);
+        EXPECT_EQ(meter.getHistogramCount(4), 2u);
+        EXPECT_EQ(meter.getHistogramCount(9), 1u);
+        EXPECT_EQ(meter.getHistogramCount(jr::CpuLoadMeter::numHistogramBins - 1), 2u);
+        EXPECT_EQ(meter.getHistogramCount(jr::CpuLoadMeter::numHistogramBins), 0u);
+
+        EXPECT_EQ(meter.getNumOverruns(), 2u);
+        EXPECT_NEAR(meter.getPeakLoad(), 20.0f, 1.0e-4f);
+    }
+
+    TEST(CpuLoadMeter, load_does_not_depend_on_block_size) {
+        jr::CpuLoadMeter small, large;
+        small.prepare(sampleRate);
+        large.prepare(sampleRate);
+
+        // the same processing cost per sample, over the same length of audio
+        for (int block = 0; block < 1600; block++)
+            small.addBlock(0.5 * 64 / sampleRate, 64);
+        for (int block = 0; block < 25; block++)
+            large.addBlock(0.5 * 4096 / sampleRate, 4096);
+
+        EXPECT_NEAR(small.getAverageLoad(), 0.5f, 0.01f);
+        EXPECT_NEAR(large.getAverageLoad(), 0.5f, 0.01f);
+    }
+
+    TEST(CpuLoadMeter, reset_clears_the_statistics_on_the_next_block) {
+        jr::CpuLoadMeter meter;
+        meter.prepare(sampleRate);
+
+        meter.addBlock(secondsForLoad(2.0), blockSize);
+        EXPECT_EQ(meter.getNumOverruns(), 1u);
+
+        meter.reset();
+        meter.addBlock(secondsForLoad(0.2), blockSize);
+
+        EXPECT_EQ(meter.getNumOverruns(), 0u);
+        EXPECT_EQ(meter.getNumBlocks(), 1u);
+        EXPECT_EQ(meter.getHistogramCount(jr::CpuLoadMeter::numHistogramBins - 1), 0u);
+        EXPECT_NEAR(meter.getPeakLoad(), 0.2f, 1.0e-6f);
+    }
+
+    TEST(CpuLoadMeter, scoped_measurement_adds_one_block) {
+        jr::CpuLoadMeter meter;
+        meter.prepare(sampleRate);
+
+        {
+            const jr::CpuLoadMeter::ScopedMeasurement measurement(meter, blockSize);
+        }
+
+        EXPECT_EQ(meter.getNumBlocks(), 1u);
+        EXPECT_GE(meter.getPeakLoad(), 0.0f);
+    }
+}
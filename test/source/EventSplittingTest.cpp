@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+#include <PhysicalModellingFan/components/audio/jr_MachineEventQueue.h>
+#include <algorithm>
+#include <vector>
+
+namespace audio_plugin_test {
+    namespace {
+        // renders with parameter changes scheduled on the timeline, collected for each block as the processor does.
+        // The control signals run at the default control interval, so their ramps are split by the blocks and the changes too
+        std::vector<float> renderWithAutomation(int blockSize) {
+            const int numSamples = 2048 * 48;
+
+            jr::Machine machine;
+            machine.prepare(48000.0f, blockSize);
+            machine.setSeed(11);
+
+            jr::MachineParameters params;
+            params.speed = 6.0f;
+            params.dopplerOn = true;
+            machine.setParameters(params);
+
+            jr::MachineEventQueue queue;
+            queue.push(1001, jr::MachineParameterId::powerUpTime, 0.3f);
+            queue.push(1001, jr::MachineParameterId::powerOn, 1.0f);
+            queue.push(30017, jr::MachineParameterId::speed, 12.0f);
+            queue.push(45555, jr::MachineParameterId::toneLevel, 0.5f);
+            queue.push(60123, jr::MachineParameterId::powerOn, 0.0f);
+
+            std::vector<jr::MachineParameterEvent> events(jr::MachineEventQueue::capacity);
+            std::vector<float> left(numSamples), right(numSamples);
+
+            for (int start = 0; start < numSamples; start += blockSize) {
+                const int numToRender = std::min(blockSize, numSamples - start);
+                const int numEvents = queue.popEventsForBlock(start, numToRender, events.data(), static_cast<int>(events.size()));
+                machine.processBlock(left.data() + start, right.data() + start, numToRender, events.data(), numEvents);
+            }
+
+            return left;
+        }
+    }
+
+    TEST(EventSplitting, automation_lands_on_the_same_sample_for_any_block_size) {
+        const auto smallBlocks = renderWithAutomation(64);
+        const auto largeBlocks = renderWithAutomation(2048);
+
+        // silent until power on is applied on its sample
+        for (int i = 0; i < 1001; i++)
+            ASSERT_EQ(smallBlocks[i], 0.0f);
+        EXPECT_NE(smallBlocks[1001], 0.0f);
+
+        EXPECT_EQ(smallBlocks, largeBlocks);
+
+        // blocks that end part way through a control interval
+        EXPECT_EQ(renderWithAutomation(100), largeBlocks);
+    }
+
+    TEST(EventSplitting, queue_converts_timeline_positions_to_block_offsets) {
+        jr::MachineEventQueue queue;
+        queue.push(-5, jr::MachineParameterId::gain, 0.1f);
+        queue.push(10, jr::MachineParameterId::gain, 0.2f);
+        queue.push(140, jr::MachineParameterId::gain, 0.3f);
+
+        jr::MachineParameterEvent events[4];
+
+        ASSERT_EQ(queue.popEventsForBlock(0, 128, events, 4), 2);
+        EXPECT_EQ(events[0].sampleOffset, 0); // late changes are applied at the start of the block
+        EXPECT_EQ(events[1].sampleOffset, 10);
+
+        ASSERT_EQ(queue.popEventsForBlock(128, 128, events, 4), 1);
+        EXPECT_EQ(events[0].sampleOffset, 12);
+        EXPECT_EQ(events[0].value, 0.3f);
+
+        EXPECT_EQ(queue.popEventsForBlock(256, 128, events, 4), 0);
+    }
+}
@@ -0,0 +1,186 @@
+#include <gtest/gtest.h>
+#include <PhysicalModellingFan/components/audio/jr_FanBank.h>
+#include <PhysicalModellingFan/components/audio/jr_SimpleFan.h>
+#include <PhysicalModellingFan/utils/jr_WorkerPool.h>
+#include <cmath>
+#include <vector>
+
+namespace audio_plugin_test {
+    namespace {
+        constexpr float sampleRate{48000.0f};
+        constexpr int numSamples{24000};
+        constexpr int maxBlockSize{512};
+
+        struct Output {
+            std::vector<float> left, right;
+        };
+
+        // renders half a second of a bank, split into blocks of the given size
+        Output render(jr::FanBank &bank, int blockSize = numSamples) {
+            Output output{std::vector<float>(numSamples), std::vector<float>(numSamples)};
+
+            for (int start = 0; start < numSamples; start += blockSize)
+                bank.processBlock(output.left.data() + start, output.right.data() + start, std::min(blockSize, numSamples - start));
+
+            return output;
+        }
+
+        void prepareBank(jr::FanBank &bank, const std::vector<jr::FanBank::VoiceParameters> &voices) {
+            bank.prepare(sampleRate, maxBlockSize, static_cast<int>(voices.size()));
+            bank.setNumVoices(static_cast<int>(voices.size()));
+            bank.setSeed(7);
+
+            for (size_t voice = 0; voice < voices.size(); voice++)
+                bank.setVoiceParameters(static_cast<int>(voice), voices[voice]);
+        }
+
+        float rms(const std::vector<float> &signal) {
+            double sum = 0.0;
+            for (auto value : signal)
+                sum += static_cast<double>(value) * value;
+
+            return static_cast<float>(std::sqrt(sum / static_cast<double>(signal.size())));
+        }
+
+        std::vector<jr::FanBank::VoiceParameters> makeVoices(int numVoices) {
+            std::vector<jr::FanBank::VoiceParameters> voices(static_cast<size_t>(numVoices));
+            for (int voice = 0; voice < numVoices; voice++) {
+                voices[static_cast<size_t>(voice)].speed = 4.0f + static_cast<float>(voice);
+                voices[static_cast<size_t>(voice)].dopplerOn = voice % 2 == 0;
+            }
+
+            return voices;
+        }
+    }
+
+    TEST(FanBank, single_voice_has_the_level_of_a_fan_propeller) {
+        jr::FanBank::VoiceParameters voice;
+        voice.speed = 10.0f;
+
+        jr::FanBank bank;
+        prepareBank(bank, {voice});
+        const auto bankOutput = render(bank);
+
+        jr::FanPropeller fan;
+        fan.setSampleRate(sampleRate);
+        fan.setMaxBlockSize(numSamples);
+        fan.setSeed(7);
+        fan.setDopplerOn(false);
+        fan.setPanWidth(voice.stereoWidth);
+
+        std::vector<float> speed(numSamples, voice.speed), left(numSamples), right(numSamples);
+        fan.processBlock(speed.data(), left.data(), right.data(), numSamples);
+
+        // the noise is different, so only the level is compared
+        EXPECT_NEAR(rms(bankOutput.left), rms(left), 0.05f * rms(left));
+        EXPECT_NEAR(rms(bankOutput.right), rms(right), 0.05f * rms(right));
+    }
+
+    TEST(FanBank, output_does_not_depend_on_the_block_size) {
+        const auto voices = makeVoices(11); // not a whole number of SIMD groups
+
+        jr::FanBank reference;
+        prepareBank(reference, voices);
+        const auto expected = render(reference);
+
+        for (int blockSize : {1, 17, 64, 100, 512}) {
+            jr::FanBank bank;
+            prepareBank(bank, voices);
+            const auto output = render(bank, blockSize);
+
+            EXPECT_EQ(output.left, expected.left) << blockSize;
+            EXPECT_EQ(output.right, expected.right) << blockSize;
+        }
+    }
+
+    TEST(FanBank, speed_scale_of_one_plays_each_voice_at_its_speed) {
+        const auto voices = makeVoices(11);
+
+        jr::FanBank reference;
+        prepareBank(reference, voices);
+        const auto expected = render(reference);
+
+        // the speed starts at its target, so the smoothing the scale skips makes no difference
+        jr::FanBank bank;
+        prepareBank(bank, voices);
+
+        const std::vector<float> speedScale(numSamples, 1.0f);
+        Output output{std::vector<float>(numSamples), std::vector<float>(numSamples)};
+        for (int start = 0; start < numSamples; start += 100)
+            bank.processBlock(speedScale.data() + start, output.left.data() + start, output.right.data() + start, std::min(100, numSamples - start));
+
+        EXPECT_EQ(output.left, expected.left);
+        EXPECT_EQ(output.right, expected.right);
+    }
+
+    TEST(FanBank, mix_is_the_sum_of_the_voices) {
+        const auto voices = makeVoices(6);
+
+        jr::FanBank bank;
+        prepareBank(bank, voices);
+        const auto mix = render(bank);
+
+        // each voice rendered on its own, with the others in the bank but silent so the noise is used the same way
+        std::vector<float> sumLeft(numSamples), sumRight(numSamples);
+        for (size_t solo = 0; solo < voices.size(); solo++) {
+            auto soloVoices = voices;
+            for (size_t voice = 0; voice < voices.size(); voice++)
+                soloVoices[voice].gain = voice == solo ? 1.0f : 0.0f;
+
+            jr::FanBank soloBank;
+            prepareBank(soloBank, soloVoices);
+            const auto output = render(soloBank);
+
+            for (size_t i = 0; i < numSamples; i++) {
+                sumLeft[i] += output.left[i];
+                sumRight[i] += output.right[i];
+            }
+        }
+
+        for (size_t i = 0; i < numSamples; i++) {
+            ASSERT_NEAR(mix.left[i], sumLeft[i], 1.0e-4f) << i;
+            ASSERT_NEAR(mix.right[i], sumRight[i], 1.0e-4f) << i;
+        }
+    }
+
+    TEST(FanBank, voices_past_the_voice_count_are_silent) {
+        jr::FanBank bank;
+        prepareBank(bank, makeVoices(8));
+
+        bank.setNumVoices(0);
+        const auto silent = render(bank);
+        EXPECT_EQ(rms(silent.left), 0.0f);
+        EXPECT_EQ(rms(silent.right), 0.0f);
+
+        // with no stereo width a voice sits in the centre
+        jr::FanBank::VoiceParameters centred;
+        centred.stereoWidth = 0.0f;
+        bank.setVoiceParameters(0, centred);
+        bank.setNumVoices(1);
+
+        const auto output = render(bank);
+        EXPECT_GT(rms(output.left), 0.0f);
+        EXPECT_EQ(output.left, output.right);
+    }
+
+    TEST(FanBank, output_does_not_depend_on_the_worker_pool) {
+        const auto voices = makeVoices(41); // ten full groups and one part filled
+
+        jr::FanBank reference;
+        prepareBank(reference, voices);
+        const auto expected = render(reference);
+
+        jr::WorkerPool pool(4);
+
+        // blocks of 32 are below the minimum and fall back to the calling thread, so both paths are covered
+        for (int blockSize : {32, 100, 512}) {
+            jr::FanBank bank;
+            prepareBank(bank, voices);
+            bank.setWorkerPool(&pool, 64);
+            const auto output = render(bank, blockSize);
+
+            EXPECT_EQ(output.left, expected.left) << blockSize;
+            EXPECT_EQ(output.right, expected.right) << blockSize;
+        }
+    }
+}
@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include <PhysicalModellingFan/components/audio/jr_FanSynth.h>
+#include <vector>
+
+namespace audio_plugin_test {
+    namespace {
+        constexpr float sampleRate{48000.0f};
+        constexpr int blockSize{512};
+
+        struct Output {
+            std::vector<float> left, right;
+        };
+
+        Output render(jr::FanSynth &synth, int numSamples) {
+            Output output{std::vector<float>(static_cast<size_t>(numSamples)), std::vector<float>(static_cast<size_t>(numSamples))};
+            synth.processBlock(output.left.data(), output.right.data(), numSamples);
+            return output;
+        }
+
+        void prepareSynth(jr::FanSynth &synth, int numVoices) {
+            jr::MachineParameters params;
+            params.speed = 8.0f;
+            params.powerUpTime = 0.1f;
+            params.powerDownTime = 0.1f;
+
+            synth.prepare(sampleRate, blockSize, numVoices);
+            synth.setSeed(3);
+            synth.setParameters(params);
+        }
+
+        bool isSilent(const std::vector<float> &signal, size_t start, size_t end) {
+            for (size_t i = start; i < end; i++)
+                if (signal[i] != 0.0f)
+                    return false;
+
+            return true;
+        }
+    }
+
+    TEST(FanSynth, notes_power_voices_on_and_off) {
+        jr::FanSynth synth;
+        prepareSynth(synth, 4);
+        EXPECT_TRUE(synth.isIdle());
+
+        const auto beforeNote = render(synth, blockSize);
+        EXPECT_TRUE(isSilent(beforeNote.left, 0, beforeNote.left.size()));
+
+        synth.noteOn(60, 1.0f);
+        synth.noteOn(67, 0.5f);
+        EXPECT_EQ(synth.getNumActiveVoices(), 2);
+        EXPECT_TRUE(synth.isNoteHeld(60));
+
+        const auto playing = render(synth, 4800);
+        EXPECT_FALSE(isSilent(playing.left, 0, playing.left.size()));
+
+        synth.noteOff(60);
+        synth.noteOff(67);
+        EXPECT_FALSE(synth.isNoteHeld(60));
+
+        // the voices power down over 0.1 s, after which they are idle and skipped
+        render(synth, 9600);
+        EXPECT_TRUE(synth.isIdle());
+        EXPECT_EQ(synth.getNumActiveVoices(), 0);
+    }
+
+    TEST(FanSynth, note_starts_on_the_sample_it_is_played) {
+        jr::FanSynth synth;
+        prepareSynth(synth, 4);
+
+        const auto beforeNote = render(synth, 100);
+        synth.noteOn(60, 1.0f);
+        const auto afterNote = render(synth, blockSize);
+
+        EXPECT_TRUE(isSilent(beforeNote.left, 0, beforeNote.left.size()));
+        EXPECT_FALSE(isSilent(afterNote.left, 0, 16));
+    }
+
+    TEST(FanSynth, the_voice_with_the_lowest_envelope_is_taken_over) {
+        jr::FanSynth synth;
+        prepareSynth(synth, 2);
+
+        // the first note has powered up fully, the second has only just started
+        synth.noteOn(60, 1.0f);
+        render(synth, 9600);
+        synth.noteOn(62, 1.0f);
+        render(synth, 48);
+
+        synth.noteOn(64, 1.0f);
+
+        EXPECT_TRUE(synth.isNoteHeld(60));
+        EXPECT_FALSE(synth.isNoteHeld(62));
+        EXPECT_TRUE(synth.isNoteHeld(64));
+        EXPECT_EQ(synth.getNumActiveVoices(), 2);
+    }
+}
@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+#include <PhysicalModellingFan/components/audio/jr_Delay.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace audio_plugin_test {
+    namespace {
+        // renders a modulated delay one sample at a time and a block at a time, returning the largest difference
+        float maxBlockVsSampleDifference(float feedback) {
+            const int numSamples = 20000;
+            const int blockSize = 333;
+            const float sampleRate = 48000.0f;
+
+            jr::FractionalDelay perSample, perBlock;
+            for (auto *delay : {&perSample, &perBlock}) {
+                delay->setSampleRate(sampleRate);
+                delay->setSize(0.4f);
+                delay->setFeedback(feedback);
+                delay->setWetMix(0.5f);
+            }
+
+            std::vector<float> in(numSamples), delayTimes(numSamples), expected(numSamples), actual(numSamples);
+            for (int i = 0; i < numSamples; i++) {
+                in[i] = std::sin(0.05f * static_cast<float>(i));
+                delayTimes[i] = 9600.0f + 480.0f * std::sin(0.001f * static_cast<float>(i));
+            }
+
+            for (int i = 0; i < numSamples; i++) {
+                perSample.setDelayTimeInSamples(delayTimes[i]);
+                expected[i] = perSample.process(in[i]);
+            }
+
+            for (int start = 0; start < numSamples; start += blockSize) {
+                const int numInBlock = std::min(blockSize, numSamples - start);
+                perBlock.process(in.data() + start, delayTimes.data() + start, actual.data() + start, numInBlock);
+            }
+
+            float maxDifference{};
+            for (int i = 0; i < numSamples; i++)
+                maxDifference = std::max(maxDifference, std::abs(expected[i] - actual[i]));
+
+            return maxDifference;
+        }
+    }
+
+    TEST(FractionalDelay, block_process_matches_per_sample_process) {
+        EXPECT_EQ(maxBlockVsSampleDifference(0.0f), 0.0f);
+    }
+
+    TEST(FractionalDelay, block_process_matches_per_sample_process_with_feedback) {
+        EXPECT_EQ(maxBlockVsSampleDifference(0.5f), 0.0f);
+    }
+
+    TEST(FractionalDelay, delays_an_impulse_by_the_delay_time) {
+        jr::FractionalDelay delay;
+        delay.setSampleRate(44100.0f);
+        delay.setSize(0.1f);
+        delay.setWetMix(1.0f);
+        delay.setDelayTimeInSamples(100.0f);
+
+        for (int i = 0; i < 200; i++) {
+            const float out = delay.process(i == 0 ? 1.0f : 0.0f);
+            EXPECT_EQ(out, i == 100 ? 1.0f : 0.0f);
+        }
+    }
+
+    TEST(FractionalDelay, buffer_is_sized_for_the_sample_rate) {
+        jr::FractionalDelay delay;
+
+        // 0.4 s plus the interpolation sample, rounded up to a power of two
+        delay.setSampleRate(48000.0f);
+        delay.setSize(0.4f);
+        EXPECT_EQ(delay.getBufferSize(), 32768);
+
+        delay.setSampleRate(192000.0f);
+        delay.setSize(0.4f);
+        EXPECT_EQ(delay.getBufferSize(), 131072);
+
+        delay.setSampleRate(44100.0f);
+        delay.setSize(0.4f);
+        EXPECT_EQ(delay.getBufferSize(), 32768);
+    }
+}
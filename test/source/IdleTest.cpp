@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include <PhysicalModellingFan/components/audio/jr_Machine.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace audio_plugin_test {
+    namespace {
+        float peak(const std::vector<float> &buffer) {
+            float peakValue{};
+            for (float sample : buffer)
+                peakValue = std::max(peakValue, std::abs(sample));
+            return peakValue;
+        }
+
+        // powers up for one block of 2048, then powers off, falls silent and powers on again, all within the second block of 2048
+        std::vector<float> renderPowerCycle(int blockSize) {
+            const int numSamples = 2048 * 3;
+
+            jr::Machine machine;
+            machine.prepare(48000.0f, blockSize);
+            machine.setSeed(13);
+
+            jr::MachineParameters params;
+            params.speed = 7.0f;
+            params.powerUpTime = 0.01f;
+            params.powerDownTime = 0.02f;
+            params.dopplerOn = true;
+            params.powerOn = true;
+            machine.setParameters(params);
+
+            // the envelope falls to 0 about 960 samples after the power off, well before the power on
+            const std::vector<jr::MachineParameterEvent> timeline{{2100, jr::MachineParameterId::powerOn, 0.0f},
+                                                                  {2500, jr::MachineParameterId::speed, 10.0f},
+                                                                  {3500, jr::MachineParameterId::powerOn, 1.0f}};
+
+            std::vector<float> left(numSamples), right(numSamples);
+            std::vector<jr::MachineParameterEvent> events;
+
+            for (int start = 0; start < numSamples; start += blockSize) {
+                events.clear();
+                for (const auto &event : timeline)
+                    if (event.sampleOffset >= start && event.sampleOffset < start + blockSize)
+                        events.push_back({event.sampleOffset - start, event.id, event.value});
+
+                machine.processBlock(left.data() + start, right.data() + start, blockSize, events.data(), static_cast<int>(events.size()));
+            }
+
+            left.insert(left.end(), right.begin(), right.end());
+            return left;
+        }
+    }
+
+    TEST(Idle, machine_goes_idle_after_power_down_and_resumes_on_power_on) {
+        const int blockSize = 512;
+
+        jr::Machine machine;
+        machine.prepare(48000.0f, blockSize);
+        machine.setSeed(5);
+
+        jr::MachineParameters params;
+        params.speed = 8.0f;
+        params.powerUpTime = 0.2f;
+        params.powerDownTime = 0.2f;
+        machine.setParameters(params);
+
+        EXPECT_TRUE(machine.isIdle());
+
+        params.powerOn = true;
+        machine.setParameters(params);
+        EXPECT_FALSE(machine.isIdle());
+
+        std::vector<float> left(blockSize), right(blockSize);
+        for (int block = 0; block < 40; block++)
+            machine.processBlock(left.data(), right.data(), blockSize);
+        EXPECT_GT(peak(left), 0.0f);
+
+        // 0.2 seconds of power down is under 20 blocks
+        params.powerOn = false;
+        machine.setParameters(params);
+        for (int block = 0; block < 20; block++)
+            machine.processBlock(left.data(), right.data(), blockSize);
+        EXPECT_TRUE(machine.isIdle());
+
+        std::fill(left.begin(), left.end(), 1.0f);
+        std::fill(right.begin(), right.end(), 1.0f);
+        machine.processBlock(left.data(), right.data(), blockSize);
+        EXPECT_EQ(peak(left), 0.0f);
+        EXPECT_EQ(peak(right), 0.0f);
+
+        params.powerOn = true;
+        machine.setParameters(params);
+        EXPECT_FALSE(machine.isIdle());
+
+        for (int block = 0; block < 40; block++)
+            machine.processBlock(left.data(), right.data(), blockSize);
+        EXPECT_GT(peak(left), 0.0f);
+    }
+
+    TEST(Idle, going_idle_inside_a_block_does_not_depend_on_the_block_size) {
+        const auto smallBlocks = renderPowerCycle(64);
+        const auto largeBlocks = renderPowerCycle(2048);
+
+        // silent between falling to 0 and the power on, and running again after it
+        EXPECT_EQ(smallBlocks[3400], 0.0f);
+        EXPECT_NE(smallBlocks[3600], 0.0f);
+
+        EXPECT_EQ(smallBlocks, largeBlocks);
+    }
+}
@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+#include <PhysicalModellingFan/components/audio/jr_Machine.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace audio_plugin_test {
+    namespace {
+        const int blockSize = 256;
+        const int numBlocks = 200;
+
+        jr::MachineParameters poweredOnParameters() {
+            jr::MachineParameters params;
+            params.speed = 6.0f;
+            params.powerUpTime = 0.5f;
+            params.dopplerOn = true;
+            params.powerOn = true;
+            return params;
+        }
+
+        // renders the machine, applying the parameters before the first block only, or before every block as the processor does
+        std::vector<float> render(bool applyEveryBlock) {
+            jr::Machine machine;
+            machine.prepare(48000.0f, blockSize);
+            machine.setSeed(3);
+
+            std::vector<float> left(blockSize * numBlocks), right(blockSize * numBlocks);
+            for (int block = 0; block < numBlocks; block++) {
+                if (block == 0 || applyEveryBlock)
+                    machine.setParameters(poweredOnParameters());
+
+                machine.processBlock(left.data() + block * blockSize, right.data() + block * blockSize, blockSize);
+            }
+
+            return left;
+        }
+    }
+
+    TEST(MachineParameters, unchanged_parameters_do_not_restart_the_envelope) {
+        EXPECT_EQ(render(false), render(true));
+    }
+
+    TEST(MachineParameters, power_is_applied_from_the_snapshot) {
+        jr::Machine machine;
+        machine.prepare(48000.0f, blockSize);
+
+        auto params = poweredOnParameters();
+        params.powerOn = false;
+        machine.setParameters(params);
+
+        std::vector<float> left(blockSize), right(blockSize);
+        machine.processBlock(left.data(), right.data(), blockSize);
+        EXPECT_EQ(left.back(), 0.0f);
+
+        params.powerOn = true;
+        machine.setParameters(params);
+        for (int block = 0; block < numBlocks; block++)
+            machine.processBlock(left.data(), right.data(), blockSize);
+
+        float peak{};
+        for (float sample : left)
+            peak = std::max(peak, std::abs(sample));
+        EXPECT_GT(peak, 0.0f);
+    }
+
+    TEST(MachineParameters, presets_are_read_by_parameter_id) {
+        const auto preset = juce::File::createTempFile(".xml");
+        ASSERT_TRUE(preset.replaceWithText("<Parameters>\n"
+                                           "  <PARAM id=\"SPEED\" value=\"9.5\"/>\n"
+                                           "  <PARAM id=\"FAN_DOPPLER\" value=\"1\"/>\n"
+                                           "  <PARAM id=\"ACCEL_RATE\" value=\"3\"/>\n"
+                                           "</Parameters>\n"));
+
+        jr::MachineParameters params;
+        params.gain = 0.25f;
+        ASSERT_TRUE(params.loadPreset(preset).wasOk());
+
+        EXPECT_EQ(params.speed, 9.5f);
+        EXPECT_TRUE(params.dopplerOn);
+        EXPECT_EQ(params.gain, 0.25f); // missing from the preset, so kept
+
+        EXPECT_EQ(jr::MachineParameters::getId("FAN_WIDTH"), jr::MachineParameterId::stereoWidth);
+        EXPECT_FALSE(jr::MachineParameters::getId("ACCEL_RATE").has_value());
+
+        preset.deleteFile();
+    }
+}
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+#include <PhysicalModellingFan/components/audio/jr_Machine.h>
+#include <cstring>
+#include <vector>
+
+namespace audio_plugin_test {
+    namespace {
+        struct Output {
+            std::vector<float> left, right;
+        };
+
+        jr::MachineParameters poweredOnParameters() {
+            jr::MachineParameters params;
+            params.speed = 9.0f;
+            params.stereoWidth = 0.8f;
+            params.powerUpTime = 0.2f;
+            params.powerDownTime = 0.2f;
+            params.dopplerOn = true;
+            params.powerOn = true;
+            return params;
+        }
+
+        void prepareMachine(jr::Machine &machine, float sampleRate, int blockSize, uint64_t seed) {
+            machine.prepare(sampleRate, blockSize);
+            machine.setSeed(seed);
+        }
+
+        // renders in blocks of blockSize, powering off part way through so the state has to carry on through a parameter change
+        Output render(jr::Machine &machine, int numSamples, int blockSize, int powerOffAt) {
+            Output output{std::vector<float>(static_cast<size_t>(numSamples)), std::vector<float>(static_cast<size_t>(numSamples))};
+
+            for (int start = 0; start < numSamples; start += blockSize) {
+                if (start == powerOffAt) {
+                    auto params = poweredOnParameters();
+                    params.powerOn = false;
+                    machine.setParameters(params);
+                }
+
+                const int numToRender = std::min(blockSize, numSamples - start);
+                machine.processBlock(output.left.data() + start, output.right.data() + start, numToRender);
+            }
+
+            return output;
+        }
+
+        bool isBitExact(const std::vector<float> &a, const std::vector<float> &b) {
+            return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0;
+        }
+    }
+
+    TEST(MachineState, restored_machine_carries_on_bit_exact) {
+        jr::Machine original;
+        prepareMachine(original, 48000.0f, 512, 3);
+        original.setParameters(poweredOnParameters());
+
+        // part way through powering up, with the delay line full and the doppler filter moving
+        render(original, 4096, 512, -1);
+
+        std::vector<unsigned char> state(original.getStateSize());
+        ASSERT_TRUE(original.saveState(state.data(), state.size()));
+
+        // the delay line only keeps the history that can still be read, not its whole buffer of 32768 samples
+        EXPECT_LT(state.size(), 32768 * sizeof(float));
+
+        // a different block size and seed, every part of which the restore replaces
+        jr::Machine restored;
+        prepareMachine(restored, 48000.0f, 256, 11);
+        ASSERT_TRUE(restored.restoreState(state.data(), state.size()));
+
+        const auto expected = render(original, 16384, 512, 8192);
+        const auto actual = render(restored, 16384, 256, 8192);
+
+        EXPECT_TRUE(isBitExact(expected.left, actual.left));
+        EXPECT_TRUE(isBitExact(expected.right, actual.right));
+    }
+
+    TEST(MachineState, state_can_be_restored_more_than_once) {
+        jr::Machine machine;
+        prepareMachine(machine, 48000.0f, 512, 3);
+        machine.setParameters(poweredOnParameters());
+        render(machine, 2048, 512, -1);
+
+        std::vector<unsigned char> state(machine.getStateSize());
+        ASSERT_TRUE(machine.saveState(state.data(), state.size()));
+
+        const auto first = render(machine, 8192, 512, -1);
+
+        // seeking back to the saved point renders the same again
+        ASSERT_TRUE(machine.restoreState(state.data(), state.size()));
+        const auto second = render(machine, 8192, 512, -1);
+
+        EXPECT_TRUE(isBitExact(first.left, second.left));
+        EXPECT_TRUE(isBitExact(first.right, second.right));
+    }
+
+    TEST(MachineState, state_that_does_not_match_is_rejected) {
+        jr::Machine original;
+        prepareMachine(original, 48000.0f, 512, 3);
+        original.setParameters(poweredOnParameters());
+        render(original, 4096, 512, -1);
+
+        std::vector<unsigned char> state(original.getStateSize());
+        EXPECT_FALSE(original.saveState(state.data(), state.size() - 1));
+        ASSERT_TRUE(original.saveState(state.data(), state.size()));
+
+        jr::Machine otherRate;
+        prepareMachine(otherRate, 44100.0f, 512, 3);
+        otherRate.setParameters(poweredOnParameters());
+        EXPECT_FALSE(otherRate.restoreState(state.data(), state.size()));
+
+        jr::Machine sameRate;
+        prepareMachine(sameRate, 48000.0f, 512, 3);
+        sameRate.setParameters(poweredOnParameters());
+        EXPECT_FALSE(sameRate.restoreState(state.data(), state.size() - 1));
+
+        // a rejected state leaves the machine as it was
+        jr::Machine untouched;
+        prepareMachine(untouched, 44100.0f, 512, 3);
+        untouched.setParameters(poweredOnParameters());
+
+        const auto expected = render(untouched, 4096, 512, -1);
+        const auto actual = render(otherRate, 4096, 512, -1);
+        EXPECT_TRUE(isBitExact(expected.left, actual.left));
+    }
+}
@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+#include <PhysicalModellingFan/components/audio/jr_Machine.h>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace audio_plugin_test {
+    namespace {
+        const std::vector<float> sampleRates{44100.0f, 48000.0f, 96000.0f, 192000.0f};
+        const int blockSize = 256;
+
+        std::unique_ptr<jr::Machine> createMachine(float sampleRate) {
+            auto machine = std::make_unique<jr::Machine>();
+            machine->prepare(sampleRate, blockSize);
+            machine->setSeed(21);
+
+            jr::MachineParameters params;
+            params.speed = 8.0f;
+            params.dopplerOn = true;
+            params.powerUpTime = 0.1f;
+            params.powerOn = true;
+            machine->setParameters(params);
+
+            return machine;
+        }
+
+        // renders a quarter of a second, so the length in samples depends on the sample rate
+        std::vector<float> render(jr::Machine &machine, float sampleRate) {
+            const int numBlocks = static_cast<int>(sampleRate / 4.0f) / blockSize;
+
+            std::vector<float> left(static_cast<size_t>(numBlocks * blockSize)), right(left.size());
+            for (int block = 0; block < numBlocks; block++)
+                machine.processBlock(left.data() + block * blockSize, right.data() + block * blockSize, blockSize);
+
+            return left;
+        }
+    }
+
+    TEST(MultiInstance, machines_at_different_rates_on_different_threads_are_independent) {
+        // each machine rendered on its own
+        std::vector<std::vector<float>> expected;
+        for (float sampleRate : sampleRates) {
+            auto machine = createMachine(sampleRate);
+            expected.push_back(render(*machine, sampleRate));
+        }
+
+        // every machine is prepared before any of them renders, so state shared between instances would be overwritten by the last rate
+        std::vector<std::unique_ptr<jr::Machine>> machines;
+        for (float sampleRate : sampleRates)
+            machines.push_back(createMachine(sampleRate));
+
+        std::vector<std::vector<float>> actual(sampleRates.size());
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < sampleRates.size(); i++)
+            threads.emplace_back([&, i]
+                                 { actual[i] = render(*machines[i], sampleRates[i]); });
+
+        for (auto &thread : threads)
+            thread.join();
+
+        for (size_t i = 0; i < sampleRates.size(); i++)
+            EXPECT_EQ(actual[i], expected[i]) << "sample rate " << sampleRates[i];
+    }
+}
@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+#include <PhysicalModellingFan/components/audio/jr_NoiseGenerator.h>
+#include <algorithm>
+#include <vector>
+
+namespace audio_plugin_test {
+    TEST(NoiseGenerator, same_seed_gives_same_output_for_any_block_size) {
+        const int numSamples = 4096;
+        jr::NoiseGenerator wholeBlock, smallBlocks;
+        wholeBlock.setSeed(1234);
+        smallBlocks.setSeed(1234);
+
+        std::vector<float> expected(numSamples), actual(numSamples);
+        wholeBlock.fillUniform(expected.data(), numSamples);
+
+        // odd block sizes so values left over from part used batches are exercised
+        for (int start = 0, blockSize = 1; start < numSamples; start += blockSize, blockSize = blockSize % 13 + 1)
+            smallBlocks.fillUniform(actual.data() + start, std::min(blockSize, numSamples - start));
+
+        EXPECT_EQ(expected, actual);
+    }
+
+    TEST(NoiseGenerator, uniform_output_is_in_range) {
+        const int numSamples = 1 << 16;
+        jr::NoiseGenerator generator;
+        generator.setSeed(1);
+
+        std::vector<float> noise(numSamples);
+        generator.fillUniform(noise.data(), numSamples);
+
+        double sum{};
+        for (float value : noise) {
+            ASSERT_GE(value, 0.0f);
+            ASSERT_LT(value, 1.0f);
+            sum += value;
+        }
+
+        EXPECT_NEAR(sum / numSamples, 0.5, 0.01);
+    }
+
+    TEST(NoiseGenerator, different_seeds_give_different_output) {
+        jr::NoiseGenerator a, b;
+        a.setSeed(1);
+        b.setSeed(2);
+
+        std::vector<float> noiseA(64), noiseB(64);
+        a.fillUniform(noiseA.data(), 64);
+        b.fillUniform(noiseB.data(), 64);
+
+        EXPECT_NE(noiseA, noiseB);
+    }
+}
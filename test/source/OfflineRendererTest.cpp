@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+#include <PhysicalModellingFan/components/services/jr_OfflineRenderer.h>
+#include <vector>
+
+namespace audio_plugin_test {
+    TEST(OfflineRenderer, automation_script_is_read_in_time_order) {
+        const auto script = juce::File::createTempFile(".txt");
+        ASSERT_TRUE(script.replaceWithText("# time parameter value\n"
+                                           "2.5 SPEED 12\n"
+                                           "\n"
+                                           "0.5 POWER 1 # comment\n"
+                                           "2.5 FAN_DOPPLER 1\n"));
+
+        std::vector<jr::AutomationPoint> points;
+        ASSERT_TRUE(jr::OfflineRenderer::loadAutomation(script, points).wasOk());
+        script.deleteFile();
+
+        ASSERT_EQ(points.size(), 3u);
+        EXPECT_EQ(points[0].timeInSeconds, 0.5);
+        EXPECT_EQ(points[0].id, jr::MachineParameterId::powerOn);
+        EXPECT_EQ(points[1].id, jr::MachineParameterId::speed); // changes at the same time keep their order
+        EXPECT_EQ(points[1].value, 12.0f);
+        EXPECT_EQ(points[2].id, jr::MachineParameterId::dopplerOn);
+    }
+
+    TEST(OfflineRenderer, bad_automation_lines_are_rejected) {
+        const auto script = juce::File::createTempFile(".txt");
+        std::vector<jr::AutomationPoint> points;
+
+        ASSERT_TRUE(script.replaceWithText("1.0 NOT_A_PARAMETER 1\n"));
+        EXPECT_TRUE(jr::OfflineRenderer::loadAutomation(script, points).failed());
+
+        ASSERT_TRUE(script.replaceWithText("1.0 SPEED\n"));
+        EXPECT_TRUE(jr::OfflineRenderer::loadAutomation(script, points).failed());
+
+        script.deleteFile();
+    }
+
+    TEST(OfflineRenderer, renders_with_the_same_seed_are_identical) {
+        const auto script = juce::File::createTempFile(".txt");
+        ASSERT_TRUE(script.replaceWithText("0.1 POWER 1\n0.3 SPEED 10\n"));
+
+        jr::RenderJob job;
+        job.automationFile = script;
+        job.durationInS = 0.5;
+        job.seed = 5;
+
+        const auto first = juce::File::createTempFile(".wav");
+        const auto second = juce::File::createTempFile(".wav");
+
+        job.outputFile = first;
+        ASSERT_TRUE(jr::OfflineRenderer::render(job).wasOk());
+        job.outputFile = second;
+        ASSERT_TRUE(jr::OfflineRenderer::render(job).wasOk());
+
+        EXPECT_GT(first.getSize(), 0);
+        EXPECT_TRUE(first.hasIdenticalContentTo(second));
+
+        script.deleteFile();
+        first.deleteFile();
+        second.deleteFile();
+    }
+
+    TEST(OfflineRenderer, fan_scenes_render_the_same_across_a_worker_pool) {
+        const auto script = juce::File::createTempFile(".txt");
+        ASSERT_TRUE(script.replaceWithText("0.0 POWER 1\n0.2 SPEED 12\n"));
+
+        jr::RenderJob job;
+        job.automationFile = script;
+        job.durationInS = 0.4;
+        job.numFans = 40;
+        job.seed = 5;
+
+        const auto singleThread = juce::File::createTempFile(".wav");
+        const auto pooled = juce::File::createTempFile(".wav");
+        const auto machine = juce::File::createTempFile(".wav");
+
+        job.outputFile = singleThread;
+        ASSERT_TRUE(jr::OfflineRenderer::render(job).wasOk());
+
+        jr::WorkerPool pool(4);
+        job.outputFile = pooled;
+        ASSERT_TRUE(jr::OfflineRenderer::render(job, &pool).wasOk());
+
+        // the same job without numFans goes through the Machine instead
+        job.numFans = 0;
+        job.outputFile = machine;
+        ASSERT_TRUE(jr::OfflineRenderer::render(job).wasOk());
+
+        EXPECT_GT(singleThread.getSize(), 0);
+        EXPECT_TRUE(singleThread.hasIdenticalContentTo(pooled));
+        EXPECT_FALSE(singleThread.hasIdenticalContentTo(machine));
+
+        job.numFans = -1;
+        EXPECT_TRUE(jr::OfflineRenderer::render(job).failed());
+
+        script.deleteFile();
+        singleThread.deleteFile();
+        pooled.deleteFile();
+        machine.deleteFile();
+    }
+}
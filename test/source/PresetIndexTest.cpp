@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+#include <PhysicalModellingFan/components/services/jr_PresetIndex.h>
+#include "TestUtils.h"
+
+namespace audio_plugin_test {
+    namespace {
+        constexpr int rescanIntervalMs{20};
+
+        juce::File writePreset(const juce::File &directory, const juce::String &name, float speed) {
+            const auto file = directory.getChildFile(name + ".preset");
+            file.replaceWithText("<PARAMETERS presetName=\"" + name + "\">\n"
+                                 "  <PARAM id=\"SPEED\" value=\"" + juce::String(speed, 2) + "\"/>\n"
+                                 "</PARAMETERS>\n");
+            return file;
+        }
+
+        // an empty directory for the presets of one test, deleted with everything in it at the end of the test
+        struct TemporaryDirectory {
+            TemporaryDirectory() { directory.createDirectory(); }
+            ~TemporaryDirectory() { directory.deleteRecursively(); }
+
+            const juce::File directory{juce::File::createTempFile("")};
+        };
+
+        struct NullListener : juce::ChangeListener {
+            void changeListenerCallback(juce::ChangeBroadcaster *) override {}
+        };
+    }
+
+    TEST(PresetIndex, first_scan_reads_every_preset_sorted_by_name) {
+        const TemporaryDirectory temporary;
+        const auto &directory = temporary.directory;
+        writePreset(directory, "Desk Fan", 4.0f);
+        writePreset(directory, "Ceiling Fan", 2.0f);
+        directory.getChildFile("notes.txt").replaceWithText("not a preset");
+
+        jr::PresetIndex index(directory, "preset", rescanIntervalMs);
+        index.getPresetNames(); // starts the scan without waiting for it
+
+        ASSERT_TRUE(waitFor([&] { return index.isReady(); }));
+
+        const auto names = index.getPresetNames();
+        ASSERT_EQ(names.size(), 2);
+        EXPECT_EQ(names[0], juce::String("Ceiling Fan"));
+        EXPECT_EQ(names[1], juce::String("Desk Fan"));
+
+        const auto deskFan = index.getPreset("Desk Fan");
+        ASSERT_TRUE(deskFan.has_value());
+        EXPECT_EQ(deskFan->parameters.speed, 4.0f);
+        EXPECT_EQ(deskFan->file, directory.getChildFile("Desk Fan.preset"));
+    }
+
+    TEST(PresetIndex, saved_and_deleted_presets_are_updated_without_a_full_scan) {
+        const TemporaryDirectory temporary;
+        const auto &directory = temporary.directory;
+
+        // a long rescan interval, so only fileChanged() and fileDeleted() can update the index in time
+        jr::PresetIndex index(directory, "preset", 60000);
+        index.getPresetNames();
+        ASSERT_TRUE(waitFor([&] { return index.isReady(); }));
+
+        const auto file = writePreset(directory, "Box Fan", 6.0f);
+        index.fileChanged(file);
+        ASSERT_TRUE(waitFor([&] { return index.getPreset("Box Fan").has_value(); }));
+        EXPECT_EQ(index.getPreset("Box Fan")->parameters.speed, 6.0f);
+
+        writePreset(directory, "Box Fan", 9.0f);
+        index.fileChanged(file);
+        EXPECT_TRUE(waitFor([&] { return index.getPreset("Box Fan")->parameters.speed == 9.0f; }));
+
+        file.deleteFile();
+        index.fileDeleted(file);
+        EXPECT_TRUE(waitFor([&] { return !index.getPreset("Box Fan").has_value(); }));
+    }
+
+    TEST(PresetIndex, changes_made_outside_the_plugin_are_found_by_the_rescan) {
+        const TemporaryDirectory temporary;
+        const auto &directory = temporary.directory;
+        const auto file = writePreset(directory, "Tower Fan", 3.0f);
+
+        jr::PresetIndex index(directory, "preset", rescanIntervalMs);
+        NullListener listener;
+        index.addWatchingListener(&listener);
+        ASSERT_TRUE(waitFor([&] { return index.isReady(); }));
+        ASSERT_TRUE(index.getPreset("Tower Fan").has_value());
+
+        // file times can be as coarse as a second, so the change is given a different time to be sure it is seen
+        writePreset(directory, "Tower Fan", 12.0f);
+        file.setLastModificationTime(juce::Time(file.getLastModificationTime().toMilliseconds() + 5000));
+        writePreset(directory, "Pedestal Fan", 5.0f);
+
+        EXPECT_TRUE(waitFor([&] { return index.getPreset("Pedestal Fan").has_value(); }));
+        EXPECT_TRUE(waitFor([&] { return index.getPreset("Tower Fan")->parameters.speed == 12.0f; }));
+
+        file.deleteFile();
+        EXPECT_TRUE(waitFor([&] { return !index.getPreset("Tower Fan").has_value(); }));
+    }
+
+    TEST(PresetIndex, directory_is_only_polled_while_it_is_watched) {
+        const TemporaryDirectory temporary;
+        const auto &directory = temporary.directory;
+
+        jr::PresetIndex index(directory, "preset", rescanIntervalMs);
+        index.getPresetNames();
+        ASSERT_TRUE(waitFor([&] { return index.isReady(); }));
+
+        // many rescan intervals go by without a scan, as nothing is watching
+        writePreset(directory, "Desk Fan", 4.0f);
+        juce::Thread::sleep(10 * rescanIntervalMs);
+        EXPECT_FALSE(index.getPreset("Desk Fan").has_value());
+
+        // a watcher rescans straight away and then keeps polling
+        NullListener listener;
+        index.addWatchingListener(&listener);
+        EXPECT_TRUE(waitFor([&] { return index.getPreset("Desk Fan").has_value(); }));
+
+        writePreset(directory, "Ceiling Fan", 2.0f);
+        EXPECT_TRUE(waitFor([&] { return index.getPreset("Ceiling Fan").has_value(); }));
+
+        index.removeWatchingListener(&listener);
+    }
+}
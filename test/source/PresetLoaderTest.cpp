@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+#include <PhysicalModellingFan/PluginProcessor.h>
+#include "TestUtils.h"
+
+namespace audio_plugin_test {
+    namespace {
+        float getValue(juce::AudioProcessorValueTreeState &apvts, const juce::String &id) {
+            return apvts.getRawParameterValue(id)->load();
+        }
+
+        void setValue(juce::AudioProcessorValueTreeState &apvts, const juce::String &id, float value) {
+            auto *parameter = apvts.getParameter(id);
+            parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+        }
+
+        // a preset file for one test, deleted at the end of the test
+        struct TemporaryPreset {
+            explicit TemporaryPreset(const juce::String &xml) { file.replaceWithText(xml); }
+            ~TemporaryPreset() { file.deleteFile(); }
+
+            const juce::File file{juce::File::createTempFile(".preset")};
+        };
+    }
+
+    TEST(PresetLoader, snapshot_reaches_the_audio_thread_before_the_apvts_changes) {
+        const juce::ScopedJuceInitialiser_GUI juceInitialiser; // the apvts is updated through the message queue
+        AudioPluginAudioProcessor processor;
+        auto &apvts = processor.getAPVTS();
+        auto &loader = processor.getPresetLoader();
+
+        setValue(apvts, ID::FAN_WIDTH, 0.75f);
+
+        const TemporaryPreset preset("<PARAMETERS presetName=\"Loud Fan\">\n"
+                                     "  <PARAM id=\"SPEED\" value=\"12.0\"/>\n"
+                                     "  <PARAM id=\"FAN_TONE\" value=\"0.25\"/>\n"
+                                     "</PARAMETERS>\n");
+
+        juce::String loadedName;
+        loader.onPresetLoaded = [&](const juce::String &presetName) { loadedName = presetName; };
+        loader.load(preset.file, "Loud Fan");
+
+        jr::MachineParameters params;
+        bool isNewPreset = false;
+        ASSERT_TRUE(waitFor([&] { return loader.getPresetParameters(params, isNewPreset) && isNewPreset; }));
+
+        EXPECT_FLOAT_EQ(params.speed, 12.0f);
+        EXPECT_FLOAT_EQ(params.toneLevel, 0.25f);
+        EXPECT_FLOAT_EQ(params.stereoWidth, 0.5f); // not in the preset, so it goes back to its default as it will in the apvts
+
+        // the message thread has not run yet, so the snapshot is all the audio thread has to go on
+        EXPECT_FLOAT_EQ(getValue(apvts, ID::SPEED), 1.0f);
+        EXPECT_TRUE(loader.getPresetParameters(params, isNewPreset));
+        EXPECT_FALSE(isNewPreset);
+
+        loader.applyLoadedPreset();
+
+        EXPECT_FLOAT_EQ(getValue(apvts, ID::SPEED), 12.0f);
+        EXPECT_FLOAT_EQ(getValue(apvts, ID::FAN_TONE), 0.25f);
+        EXPECT_FLOAT_EQ(getValue(apvts, ID::FAN_WIDTH), params.stereoWidth);
+        EXPECT_EQ(loadedName, juce::String("Loud Fan"));
+
+        // the host parameters hold the preset now, so they are used again
+        EXPECT_FALSE(loader.getPresetParameters(params, isNewPreset));
+        EXPECT_FALSE(isNewPreset);
+    }
+}
@@ -0,0 +1,44 @@
+#include <gtest/gtest.h>
+#include <PhysicalModellingFan/components/audio/jr_PulseShaper.h>
+#include <cmath>
+#include <vector>
+
+namespace audio_plugin_test {
+    namespace {
+        // the waveshaping formula used by FanToneComponent before the block kernel
+        float referencePulse(float sine, float pulseWidth) {
+            return static_cast<float>(1.0 / (1.0 + pow(sine * pulseWidth, 2)));
+        }
+
+        template <bool useFastReciprocal>
+        float maxErrorAcrossPulseWidths() {
+            const int numSamples = 1001; // odd length so the SIMD tail is exercised
+            std::vector<float> sine(numSamples), rawSignal(numSamples), out(numSamples);
+
+            for (int i = 0; i < numSamples; i++)
+                sine[i] = std::sin(6.283185307f * static_cast<float>(i) / static_cast<float>(numSamples - 1));
+
+            float maxError{};
+            for (float pulseWidth = 0.25f; pulseWidth <= 32.0f; pulseWidth *= 1.25f) {
+                // offset by one sample so the kernel also sees unaligned buffers
+                jr::PulseShaper::processWith<useFastReciprocal>(sine.data() + 1, pulseWidth, 0.5f, rawSignal.data() + 1, out.data() + 1, numSamples - 1);
+
+                for (int i = 1; i < numSamples; i++) {
+                    const float expected = referencePulse(sine[i], pulseWidth);
+                    maxError = std::max(maxError, std::abs(rawSignal[i] - expected));
+                    EXPECT_FLOAT_EQ(out[i], rawSignal[i] * 0.5f);
+                }
+            }
+            return maxError;
+        }
+    }
+
+    TEST(PulseShaper, exact_reciprocal_matches_reference_formula) {
+        EXPECT_LT(maxErrorAcrossPulseWidths<false>(), 1.0e-6f);
+    }
+
+    TEST(PulseShaper, fast_reciprocal_is_within_tolerance_of_reference_formula) {
+        // a 12 bit estimate (SSE) refines to below 2.5e-7, an 8 bit estimate (NEON) to around 1.5e-5
+        EXPECT_LT(maxErrorAcrossPulseWidths<true>(), 5.0e-5f);
+    }
+}
@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+#include <PhysicalModellingFan/components/services/jr_StateCodec.h>
+#include <PhysicalModellingFan/ParameterIDs.h>
+#include <vector>
+
+namespace audio_plugin_test {
+    namespace {
+        juce::MemoryBlock encodeFanState() {
+            const std::vector<jr::StateCodec::Parameter> parameters{
+                {ID::SPEED.toRawUTF8(), 12.5f},
+                {ID::FAN_WIDTH.toRawUTF8(), 0.75f},
+                {ID::POWER.toRawUTF8(), 1.0f}};
+
+            juce::MemoryBlock block;
+            jr::StateCodec::encode(block, parameters, "Desk Fan");
+            return block;
+        }
+    }
+
+    TEST(StateCodec, decoded_state_matches_the_encoded_state) {
+        const auto block = encodeFanState();
+
+        jr::StateCodec::State state;
+        ASSERT_TRUE(jr::StateCodec::decode(block.getData(), block.getSize(), state).wasOk());
+
+        ASSERT_EQ(state.numParameters, 3);
+        EXPECT_EQ(state.parameters[0].id, std::string_view("SPEED"));
+        EXPECT_EQ(state.parameters[0].value, 12.5f);
+        EXPECT_EQ(state.parameters[1].id, std::string_view("FAN_WIDTH"));
+        EXPECT_EQ(state.parameters[1].value, 0.75f);
+        EXPECT_EQ(state.parameters[2].id, std::string_view("POWER"));
+        EXPECT_EQ(state.parameters[2].value, 1.0f);
+        EXPECT_EQ(state.presetName, std::string_view("Desk Fan"));
+    }
+
+    TEST(StateCodec, damaged_and_newer_states_are_rejected) {
+        const auto block = encodeFanState();
+        const auto *bytes = static_cast<const char *>(block.getData());
+        jr::StateCodec::State state;
+
+        // every possible truncation stops inside a field
+        for (size_t size = 0; size < block.getSize(); size++)
+            EXPECT_TRUE(jr::StateCodec::decode(bytes, size, state).failed()) << size;
+
+        std::vector<char> newer(bytes, bytes + block.getSize());
+        newer[4] = static_cast<char>(jr::StateCodec::currentVersion + 1);
+        EXPECT_TRUE(jr::StateCodec::decode(newer.data(), newer.size(), state).failed());
+
+        std::vector<char> tooManyParameters(bytes, bytes + block.getSize());
+        tooManyParameters[6] = static_cast<char>(jr::StateCodec::maxParameters + 1);
+        EXPECT_TRUE(jr::StateCodec::decode(tooManyParameters.data(), tooManyParameters.size(), state).failed());
+    }
+
+    TEST(StateCodec, xml_states_are_not_taken_for_binary_states) {
+        // copyXmlToBinary() data starts with this magic number, little endian
+        const unsigned char xmlState[] = {0x56, 0x43, 0x32, 0x21, 0x10, 0x00, 0x00, 0x00, '<', 'P', 'A', 'R'};
+
+        EXPECT_FALSE(jr::StateCodec::isBinaryState(xmlState, sizeof(xmlState)));
+        EXPECT_FALSE(jr::StateCodec::isBinaryState(nullptr, 0));
+
+        const auto block = encodeFanState();
+        EXPECT_TRUE(jr::StateCodec::isBinaryState(block.getData(), block.getSize()));
+    }
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <functional>
+
+namespace audio_plugin_test {
+    /**
+    Waits for work on a background thread to catch up, checking the condition every few milliseconds
+    * @param condition - returns true once the work is done
+    * @param timeoutMs - longest time to wait (ms)
+    * @return false if the condition was still false after the timeout
+    */
+    inline bool waitFor(const std::function<bool()> &condition, int timeoutMs = 5000) {
+        const auto endTime = juce::Time::getMillisecondCounter() + static_cast<juce::uint32>(timeoutMs);
+
+        while (!condition()) {
+            if (static_cast<int>(endTime - juce::Time::getMillisecondCounter()) <= 0)
+                return false;
+
+            juce::Thread::sleep(2);
+        }
+
+        return true;
+    }
+}
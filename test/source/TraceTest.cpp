@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include <PhysicalModellingFan/utils/jr_Trace.h>
+#include <thread>
+
+namespace audio_plugin_test {
+    namespace {
+        // returns the first event in a parsed trace with a name, or a void var if there is none
+        juce::var findEvent(const juce::var &trace, const juce::String &name) {
+            if (const auto *events = trace["traceEvents"].getArray())
+                for (const auto &event : *events)
+                    if (event["name"].toString() == name)
+                        return event;
+
+            return {};
+        }
+
+        juce::var findThreadName(const juce::var &trace, int tid) {
+            if (const auto *events = trace["traceEvents"].getArray())
+                for (const auto &event : *events)
+                    if (event["name"].toString() == "thread_name" && static_cast<int>(event["tid"]) == tid)
+                        return event;
+
+            return {};
+        }
+    }
+
+    TEST(Trace, events_from_each_thread_are_written_as_chrome_trace_json) {
+        const auto start = juce::Time::getHighResolutionTicks();
+        const auto oneMillisecond = juce::Time::getHighResolutionTicksPerSecond() / 1000;
+
+        jr::Trace::setThreadName("TraceTest main");
+        jr::Trace::record("TraceTest main event", start, start + oneMillisecond);
+
+        std::thread worker([&] {
+            jr::Trace::setThreadName("TraceTest worker");
+            jr::Trace::record("TraceTest worker event", start, start + 2 * oneMillisecond);
+        });
+        worker.join();
+
+        const auto trace = juce::JSON::parse(jr::Trace::toJson());
+        ASSERT_TRUE(trace.isObject());
+
+        const auto mainEvent = findEvent(trace, "TraceTest main event");
+        const auto workerEvent = findEvent(trace, "TraceTest worker event");
+        ASSERT_TRUE(mainEvent.isObject());
+        ASSERT_TRUE(workerEvent.isObject());
+
+        EXPECT_EQ(mainEvent["ph"].toString(), juce::String("X"));
+        EXPECT_NEAR(static_cast<double>(mainEvent["dur"]), 1000.0, 1.0);
+        EXPECT_NEAR(static_cast<double>(workerEvent["dur"]), 2000.0, 1.0);
+        EXPECT_NEAR(static_cast<double>(mainEvent["ts"]), static_cast<double>(workerEvent["ts"]), 1.0e-3);
+
+        const int mainThread = mainEvent["tid"];
+        const int workerThread = workerEvent["tid"];
+        EXPECT_NE(mainThread, workerThread);
+
+        EXPECT_EQ(findThreadName(trace, mainThread)["args"]["name"].toString(), juce::String("TraceTest main"));
+        EXPECT_EQ(findThreadName(trace, workerThread)["args"]["name"].toString(), juce::String("TraceTest worker"));
+    }
+
+    TEST(Trace, oldest_events_are_overwritten_once_a_thread_buffer_is_full) {
+        const auto eventsBefore = jr::Trace::getNumEvents();
+        const auto overwrittenBefore = jr::Trace::getNumOverwrittenEvents();
+        const int numExtra = 10;
+
+        // a new thread starts with an empty buffer
+        std::thread worker([&] {
+            jr::Trace::record("TraceTest oldest", 0, 0);
+
+            for (int i = 1; i < jr::Trace::eventsPerThread + numExtra - 1; i++)
+                jr::Trace::record("TraceTest fill", 0, 0);
+
+            jr::Trace::record("TraceTest newest", 0, 0);
+        });
+        worker.join();
+
+        EXPECT_EQ(jr::Trace::getNumEvents() - eventsBefore, jr::Trace::eventsPerThread + numExtra);
+        EXPECT_EQ(jr::Trace::getNumOverwrittenEvents() - overwrittenBefore, numExtra);
+
+        const auto trace = juce::JSON::parse(jr::Trace::toJson());
+        ASSERT_TRUE(trace.isObject());
+        EXPECT_TRUE(findEvent(trace, "TraceTest oldest").isVoid());
+        EXPECT_TRUE(findEvent(trace, "TraceTest newest").isObject());
+    }
+
+    TEST(Trace, threads_record_into_reserved_buffers) {
+        jr::Trace::reserveThreadBuffers(1);
+
+        std::thread worker([] {
+            jr::Trace::setThreadName("TraceTest reserved");
+            jr::Trace::record("TraceTest reserved event", 0, 0);
+        });
+        worker.join();
+
+        const auto trace = juce::JSON::parse(jr::Trace::toJson());
+        const auto event = findEvent(trace, "TraceTest reserved event");
+        ASSERT_TRUE(event.isObject());
+        EXPECT_EQ(findThreadName(trace, event["tid"])["args"]["name"].toString(), juce::String("TraceTest reserved"));
+    }
+
+    TEST(Trace, markers_only_record_when_tracing_is_enabled) {
+        const auto eventsBefore = jr::Trace::getNumEvents();
+
+        {
+            JR_TRACE_SCOPE("TraceTest marker");
+        }
+
+        EXPECT_EQ(jr::Trace::getNumEvents() - eventsBefore, JR_ENABLE_TRACING ? 1 : 0);
+    }
+}
@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include <PhysicalModellingFan/utils/jr_TripleBuffer.h>
+#include <thread>
+
+namespace audio_plugin_test {
+    namespace {
+        // every field is written with the same value, so a value read part way through being written would not match itself
+        struct Values {
+            int a{};
+            int b{};
+            int c{};
+            int d{};
+        };
+    }
+
+    TEST(TripleBuffer, read_returns_only_the_latest_value_once) {
+        jr::TripleBuffer<int> buffer;
+        int value = -1;
+
+        EXPECT_FALSE(buffer.read(value));
+        EXPECT_EQ(value, -1);
+
+        buffer.write(1);
+        buffer.write(2);
+        buffer.write(3);
+
+        EXPECT_TRUE(buffer.read(value));
+        EXPECT_EQ(value, 3);
+
+        EXPECT_FALSE(buffer.read(value));
+        EXPECT_EQ(value, 3);
+
+        buffer.write(4);
+        EXPECT_TRUE(buffer.read(value));
+        EXPECT_EQ(value, 4);
+    }
+
+    TEST(TripleBuffer, values_written_on_another_thread_are_never_torn) {
+        jr::TripleBuffer<Values> buffer;
+        constexpr int numWrites{200000};
+
+        std::thread writer([&] {
+            for (int i = 1; i <= numWrites; i++)
+                buffer.write({i, i, i, i});
+        });
+
+        Values values;
+        int lastValue = 0;
+        bool inOrder = true;
+        bool torn = false;
+
+        while (lastValue < numWrites) {
+            if (!buffer.read(values))
+                continue;
+
+            torn = torn || values.b != values.a || values.c != values.a || values.d != values.a;
+            inOrder = inOrder && values.a > lastValue;
+            lastValue = values.a;
+        }
+
+        writer.join();
+
+        EXPECT_FALSE(torn);
+        EXPECT_TRUE(inOrder);
+        EXPECT_EQ(lastValue, numWrites);
+    }
+}
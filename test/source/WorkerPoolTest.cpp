@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+#include <PhysicalModellingFan/utils/jr_WorkerPool.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace audio_plugin_test {
+    TEST(WorkerPool, every_item_runs_once_in_each_loop) {
+        jr::WorkerPool pool(4);
+        EXPECT_EQ(pool.getNumThreads(), 4);
+
+        for (int numItems : {0, 1, 3, 4, 37, 1000}) {
+            std::vector<std::atomic<int>> counts(static_cast<size_t>(numItems));
+
+            // many short loops one after another, so workers that wake up late for a loop are caught out
+            for (int loop = 0; loop < 200; loop++)
+                pool.parallelFor(numItems, [&](int item) { counts[static_cast<size_t>(item)]++; });
+
+            for (int item = 0; item < numItems; item++)
+                ASSERT_EQ(counts[static_cast<size_t>(item)].load(), 200) << numItems << " items, item " << item;
+        }
+    }
+
+    TEST(WorkerPool, items_are_shared_across_the_threads) {
+        jr::WorkerPool pool(4);
+
+        std::mutex lock;
+        std::set<std::thread::id> threads;
+
+        // each item sleeps, so the workers get to run even on a machine with a single core
+        pool.parallelFor(16, [&](int) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            const std::lock_guard<std::mutex> guard(lock);
+            threads.insert(std::this_thread::get_id());
+        });
+
+        EXPECT_GT(threads.size(), 1u);
+        EXPECT_LE(threads.size(), 4u);
+    }
+
+    TEST(WorkerPool, single_thread_pool_runs_on_the_calling_thread) {
+        jr::WorkerPool pool(1);
+        EXPECT_EQ(pool.getNumThreads(), 1);
+
+        const auto caller = std::this_thread::get_id();
+        std::vector<int> order;
+        pool.parallelFor(5, [&](int item) {
+            EXPECT_EQ(std::this_thread::get_id(), caller);
+            order.push_back(item);
+        });
+
+        EXPECT_EQ(order, (std::vector<int>{0, 1, 2, 3, 4}));
+    }
+}